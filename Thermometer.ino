@@ -2,8 +2,20 @@
 #include <Keypad.h>
 #include <DHT.h>
 
+// Uncomment to compile in scripted key replay (the KEYS, SCREEN, EXPECT, EXPECTSET and DRYRUN serial commands)
+// #define KEY_REPLAY
+
+#include "keys.h"
+#include "lcd.h"
+#include "memory.h"
 #include "menu.h"
+#include "power.h"
+#include "restart.h"
+#include "runtime.h"
+#include "sensors.h"
 #include "temp_mgr.h"
+#include "weather.h"
+#include "zones.h"
 
 #define LCD_COLS 16
 #define LCD_ROWS 2
@@ -11,6 +23,13 @@
 #define DHT_PIN 2
 #define DHT_TYPE DHT22
 
+// Uncomment if a second DHT22 is wired up outdoors
+// Without it the outdoor temperature can be pushed with the "OUT <temp>" serial command
+// #define OUTDOOR_DHT_PIN A1
+
+// How often the RTC is read if no square wave edge arrives first, in ms
+#define RTC_POLL_INTERVAL 1000UL
+
 char KEYMAP[4][4] = {
     {'7', '8', '9', 'U'},
     {'4', '5', '6', 'D'},
@@ -18,57 +37,288 @@ char KEYMAP[4][4] = {
     {'.', '0', 'B', 'K'}
 };
 
-LiquidCrystal_I2C display = LiquidCrystal_I2C(0x27, LCD_COLS, LCD_ROWS);
+MenuDisplay display = MenuDisplay(0x27, LCD_COLS, LCD_ROWS);
+
+byte KEYPAD_ROW_PINS[4] = {9, 8, 7, 6};
+byte KEYPAD_COL_PINS[4] = {13, 11, 12, 10};
 
 Keypad keypad = Keypad(
     makeKeymap(KEYMAP),
-    (byte[]) {9, 8, 7, 6},
-    (byte[]) {13, 11, 12, 10},
+    KEYPAD_ROW_PINS,
+    KEYPAD_COL_PINS,
     (byte) 4,
     (byte) 4
 );
 
+#ifdef KEY_REPLAY
+KeyInput key_input = KeyInput(&keypad);
+#endif
+
 DHT dht(DHT_PIN, DHT_TYPE);
 
+DHT* primary_sensors[] = {&dht};
+const float primary_sensor_weights[] = {1};
+SensorGroup primary_sensor_group = SensorGroup(primary_sensors, primary_sensor_weights, 1, AggregateMode::Average);
+
+#ifdef OUTDOOR_DHT_PIN
+DHT outdoor_dht(OUTDOOR_DHT_PIN, DHT_TYPE);
+OutdoorTemp outdoor = OutdoorTemp(&outdoor_dht);
+#else
+OutdoorTemp outdoor = OutdoorTemp(NULL);
+#endif
+
 RTC_DS1307 rtc = RTC_DS1307();
 
 Settings settings;
 
-TempMgr temp_mgr = TempMgr(&settings, &rtc);
+TempMgr temp_mgr = TempMgr(&settings, &rtc, RelayPins {HEAT_PIN, COOL_PIN, FAN_PIN}, &outdoor);
 
-Menu menu = Menu(LCD_COLS, LCD_ROWS, &display, &keypad, &settings, &rtc, &temp_mgr);
+/*
+Every zone is updated from the same control tick. Zone 0 is the one shown on the display.
+Only zone 0 is wired up. Another zone needs its own sensors, a `Settings(n)` and a TempMgr on its own relay pins,
+and the runtime log and menu only ever follow zone 0.
+*/
+Zone zone_list[] = {
+    {&primary_sensor_group, &temp_mgr, &settings}
+};
+static_assert(sizeof(zone_list) / sizeof(zone_list[0]) == N_ZONES, "zone_list needs exactly one entry per zone");
+ZoneTable<N_ZONES> zones = ZoneTable<N_ZONES>(zone_list);
+
+RuntimeLog runtime_log = RuntimeLog(&rtc);
+
+Menu menu = Menu(LCD_COLS, LCD_ROWS, &display, &keypad, &settings, &rtc, &temp_mgr, &runtime_log);
+
+PowerMgr power = PowerMgr(&display, KEYPAD_ROW_PINS, KEYPAD_COL_PINS, 4, 4);
 
 bool update_display;
 
+// Serial command buffer, longer with key replay so EXPECTSET fits a whole settings line
+#ifdef KEY_REPLAY
+#define SERIAL_CMD_LEN 40
+#else
+#define SERIAL_CMD_LEN 32
+#endif
+char serial_cmd[SERIAL_CMD_LEN];
+uint8_t serial_cmd_len = 0;
+
 float old_temp;
+float old_humidity;
 DateTime old_time;
+unsigned long last_rtc_poll;
+
+// Prints the size of every statically allocated object
+void print_object_sizes() {
+    Serial.print(F("Static objects: display "));
+    Serial.print(sizeof(display));
+    Serial.print(F(", keypad "));
+#ifdef KEY_REPLAY
+    Serial.print(sizeof(keypad) + sizeof(key_input));
+#else
+    Serial.print(sizeof(keypad));
+#endif
+    Serial.print(F(", dht "));
+    Serial.print(sizeof(dht) + sizeof(primary_sensor_group));
+    Serial.print(F(", settings "));
+    Serial.print(sizeof(settings));
+    Serial.print(F(" ("));
+    Serial.print(sizeof(TempSetting));
+    Serial.print(F("B per temp setting), temp_mgr "));
+    Serial.print(sizeof(temp_mgr));
+    Serial.print(F(", zones "));
+    Serial.print(sizeof(zones) + sizeof(zone_list));
+    Serial.print(F(", runtime_log "));
+    Serial.print(sizeof(runtime_log));
+    Serial.print(F(", menu "));
+    Serial.print(sizeof(menu));
+    Serial.print(F(", power "));
+    Serial.print(sizeof(power));
+    Serial.print(F(", snapshot "));
+    Serial.print(sizeof(_runtime_snapshot));
+    Serial.print(F(", serial_cmd "));
+    Serial.println(sizeof(serial_cmd));
+}
+
+// Runs a command received over serial
+void run_serial_command(const char* cmd) {
+    if (strcmp_P(cmd, PSTR("RUNTIME")) == 0) {
+        runtime_log.export_csv(Serial);
+    }
+    else if (strcmp_P(cmd, PSTR("POWER")) == 0) {
+        power.print_stats(Serial);
+    }
+    // OUT <temp> - Sets the outdoor temperature, OUT on its own prints it and the learned heat loss
+    else if (strncmp_P(cmd, PSTR("OUT "), 4) == 0) {
+        char* end;
+        float temp = strtod(cmd + 4, &end);
+        if (end == cmd + 4 || *end != '\0' || !outdoor.set(temp)) {
+            Serial.print(F("Invalid outdoor temperature: "));
+            Serial.println(cmd + 4);
+        }
+    }
+    else if (strcmp_P(cmd, PSTR("OUT")) == 0) {
+        Serial.print(F("Outdoor: "));
+        Serial.print(outdoor.temperature());
+        Serial.print(F("C, heat loss: "));
+        Serial.print(temp_mgr.heat_loss_coefficient(), 3);
+        Serial.println(F("/h"));
+    }
+    else if (strcmp_P(cmd, PSTR("MEM")) == 0) {
+        print_object_sizes();
+        print_memory_report(Serial);
+    }
+#ifdef KEY_REPLAY
+    // KEYS <keys> - Queues keys to be replayed as if they were pressed on the keypad
+    else if (strncmp_P(cmd, PSTR("KEYS "), 5) == 0) {
+        if (!key_input.queue_keys(cmd + 5)) {
+            Serial.println(F("Key queue full"));
+        }
+    }
+    // DRYRUN <0|1> - While on, the menu doesn't set the RTC or save the settings to EEPROM
+    else if (strncmp_P(cmd, PSTR("DRYRUN "), 7) == 0) {
+        menu.set_dry_run(cmd[7] == '1');
+    }
+    else if (strcmp_P(cmd, PSTR("SCREEN")) == 0) {
+        display.print_shadow(Serial);
+    }
+    else if (strcmp_P(cmd, PSTR("SETTINGS")) == 0) {
+        settings.print_settings(Serial);
+    }
+    // EXPECT <row> <text> - Checks that the screen shows `text` on `row`
+    else if (strncmp_P(cmd, PSTR("EXPECT "), 7) == 0 && cmd[7] >= '0' && cmd[7] <= '9' && cmd[8] == ' ') {
+        if (display.row_equals(cmd[7] - '0', cmd + 9)) {
+            Serial.println(F("PASS"));
+        } else {
+            Serial.println(F("FAIL"));
+            display.print_shadow(Serial);
+        }
+    }
+    // EXPECTSET <line> - Checks that `line` is one of the lines printed by SETTINGS, e.g. "EXPECTSET mode: 4"
+    else if (strncmp_P(cmd, PSTR("EXPECTSET "), 10) == 0) {
+        LineMatcher matcher(cmd + 10);
+        settings.print_settings(matcher);
+        if (matcher.matched) {
+            Serial.println(F("PASS"));
+        } else {
+            Serial.println(F("FAIL"));
+            settings.print_settings(Serial);
+        }
+    }
+#endif
+    else {
+        Serial.print(F("Unknown command: "));
+        Serial.println(cmd);
+    }
+}
+
+// Reads serial input and runs each complete line as a command
+void process_serial() {
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\r') {
+            continue;
+        }
+        if (c != '\n') {
+            if (serial_cmd_len < SERIAL_CMD_LEN - 1) {
+                serial_cmd[serial_cmd_len++] = c;
+            }
+            continue;
+        }
+        serial_cmd[serial_cmd_len] = '\0';
+        serial_cmd_len = 0;
+        run_serial_command(serial_cmd);
+    }
+}
+
+/*
+Returns the next key for both the standby loop and the menu, NO_KEY if there's none
+The first key press after the backlight turned off only turns it back on
+*/
+char read_key() {
+#ifdef KEY_REPLAY
+    char key = key_input.get_key();
+    // Replayed keys are always acted on so recorded sequences stay reproducible
+    bool replayed = key_input.last_key_replayed();
+#else
+    char key = keypad.getKey();
+    bool replayed = false;
+#endif
+    if (key == NO_KEY) {
+        return NO_KEY;
+    }
+    if (!power.key_pressed() && !replayed) {
+        return NO_KEY;
+    }
+    return key;
+}
+
+// Work that keeps running while the menu is waiting for input
+void run_background_tasks() {
+    wdt_reset();
+    power.update_backlight();
+    outdoor.update();
+    if (zones.update_call_timer()) {
+        runtime_log.update(temp_mgr.outputs());
+        update_display = true;
+    }
+    save_snapshot(zones, runtime_log);
+    process_serial();
+    check_memory(Serial);
+}
 
 void setup() {
+    // Resume control before bringing up anything slow, so a brownout doesn't interrupt a running cycle
+    bool warm_restart = restore_snapshot(zones);
+    unsigned long control_resumed_us = micros();
+    wdt_enable(WATCHDOG_TIMEOUT);
+    paint_stack();
+
     Serial.begin(9600);
-    Serial.print(F("Got sizeof TempSetting: "));
-    Serial.println(String(sizeof(TempSetting)));
+    print_reset_cause(Serial);
+    print_object_sizes();
     Serial.print(F("Got "));
     Serial.print(String(MAX_CMPLX_TEMPS));
     Serial.println(F(" max temp settings"));
     display.init();
     display.backlight();
-    display.print(F("Starting setup..."));
-    dht.begin();
-    display.setCursor(0, 1);
-    display.print(F("dht"));
+    menu.begin();
+    // Skip the progress text on a warm restart, the standby screen is shown as soon as the loop starts
+    if (!warm_restart) {
+        display.print(F("Starting setup..."));
+    }
     rtc.begin();
-    display.print(F(", rtc"));
-    settings.begin();
-    display.print(F(", settings"));
-    pinMode(HEAT_PIN, OUTPUT);
-    pinMode(COOL_PIN, OUTPUT);
-    pinMode(FAN_PIN, OUTPUT);
-    digitalWrite(HEAT_PIN, HIGH);
-    digitalWrite(COOL_PIN, HIGH);
-    digitalWrite(FAN_PIN, HIGH);
-    display.print(F(", pins"));
-    display.clear();
-    display.print(F("Finshed setup"));
+    rtc.writeSqwPinMode(DS1307_SquareWave1HZ);
+    if (!warm_restart) {
+        display.setCursor(0, 1);
+        display.print(F("rtc"));
+    }
+    zones.begin_settings();
+    if (!warm_restart) {
+        display.print(F(", settings"));
+    }
+    outdoor.begin();
+    // Pick up the runtime counters where they were, without counting the resumed outputs as new cycles
+    if (warm_restart) {
+        runtime_log.begin(snapshot_runtime(), temp_mgr.outputs());
+    } else {
+        runtime_log.begin();
+    }
+    power.begin();
+    menu.set_idle_task(run_background_tasks);
+    menu.set_key_source(read_key);
+#ifdef KEY_REPLAY
+    key_input.set_report(&Serial, &zones.missed_ticks);
+#endif
+    if (!warm_restart) {
+        display.clear();
+        display.print(F("Finshed setup"));
+    }
+
+    Serial.print(warm_restart ? F("Warm restart") : F("Cold start"));
+    Serial.print(F(", control resumed after "));
+    Serial.print(control_resumed_us);
+    Serial.print(F("us, setup finished after "));
+    Serial.print(millis());
+    Serial.println(F("ms"));
 }
 
 void loop() {
@@ -79,7 +329,7 @@ void loop() {
     // TODO: Look into making menu run off events
     // keypad.addEventListener()
     */
-    char key = keypad.getKey();
+    char key = read_key();
     // TODO: Make backlight flash when a key is pressed
     if (key) {
         Serial.print(F("loop() got key: "));
@@ -87,39 +337,62 @@ void loop() {
     }
     // TODO: Flash target temperature when it's being changed (while it differs from what's stored on eeprom?)
     if (key == 'U') {
-        float new_temp = settings.simple_temp_setting.target_temp();
-        new_temp += .5;
-        settings.simple_temp_setting.target_temp(new_temp);
+        settings.simple_temp_setting.shift(.5);
         update_display = true;
     }
     else if (key == 'D') {
-        float new_temp = settings.simple_temp_setting.target_temp();
-        new_temp -= .5;
-        settings.simple_temp_setting.target_temp(new_temp);
+        settings.simple_temp_setting.shift(-.5);
         update_display = true;
     }
     else if (key == 'K') {
-        settings.save_settings();
+        menu.save_settings();
     }
     else if (key == 'M') {
         menu.run_menu();
         update_display = true;
     }
-
-    float current_temp = dht.readTemperature();
-    if (temp_mgr.update_call_timer(current_temp)) {
+    else if (key == 'B') {
+        menu.next_standby_page();
         update_display = true;
     }
+    // Show the response to a key before the background work runs
+    if (update_display) {
+        menu.print_standby(zones[0].sensors);
+        update_display = false;
+    }
+#ifdef KEY_REPLAY
+    key_input.rendered();
+#endif
+
+    run_background_tasks();
+    float current_temp = zones[0].sensors->temperature();
     if (current_temp != old_temp) {
         old_temp = current_temp;
         update_display = true;
     }
-    DateTime now = rtc.now();
-    if (now.minute() != old_time.minute()) {
-        old_time = now;
+    float current_humidity = zones[0].sensors->humidity();
+    if (current_humidity != old_humidity) {
+        old_humidity = current_humidity;
         update_display = true;
     }
+    // Only read the RTC when its square wave ticks (or every RTC_POLL_INTERVAL without it)
+    if (power.rtc_ticked() || millis() - last_rtc_poll >= RTC_POLL_INTERVAL) {
+        last_rtc_poll = millis();
+        DateTime now = rtc.now();
+        if (now.minute() != old_time.minute()) {
+            old_time = now;
+            runtime_log.update(temp_mgr.outputs());
+            update_display = true;
+        }
+    }
     if (update_display) {
-        menu.print_standby(current_temp);
+        menu.print_standby(zones[0].sensors);
     }
+
+    // Sleep until the next control tick or RTC poll, whichever comes first
+    unsigned long since_rtc_poll = millis() - last_rtc_poll;
+    unsigned long rtc_poll_in = since_rtc_poll >= RTC_POLL_INTERVAL ? 0 : RTC_POLL_INTERVAL - since_rtc_poll;
+    unsigned long tick_in = zones.time_until_tick();
+    power.idle(tick_in < rtc_poll_in ? tick_in : rtc_poll_in);
 }
+
@@ -0,0 +1,187 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+Micro-benchmarks for the hot paths, built natively against the stubs in host/ (see the Makefile)
+Every result is printed as one JSON object per line
+"bytes_allocated_per_op" counts every byte requested from malloc / realloc, whether or not it's freed again.
+"i2c_bytes_per_op" counts the bytes the fake Wire would have put on the bus, addresses included.
+*/
+
+#include <Keypad.h>
+#include <RTClib.h>
+#include <Wire.h>
+
+#include "host.h"
+#include "lcd.h"
+#include "menu.h"
+#include "runtime.h"
+#include "sensors.h"
+#include "settings.h"
+#include "temp_mgr.h"
+
+#define BENCH_ITERATIONS 100000UL
+// add_temp_setting refills the schedule between iterations, which isn't timed
+#define BENCH_ADD_ITERATIONS 10000UL
+#define BENCH_STANDBY_ITERATIONS 10000UL
+
+class Benchmarks {
+    public:
+    Benchmarks(int lcd_cols, int lcd_rows, Keypad* keypad, RTC_DS1307* rtc, RuntimeLog* runtime_log, SensorGroup* sensors) {
+        this->lcd_cols = lcd_cols;
+        this->lcd_rows = lcd_rows;
+        this->keypad = keypad;
+        this->rtc = rtc;
+        this->runtime_log = runtime_log;
+        this->sensors = sensors;
+    }
+
+    void run(Print& out) {
+        Settings settings;
+        settings.mode = Mode::Auto;
+        settings.control_mode = ControlMode::Complex;
+        settings.simple_temp_setting.set_temps(20, 24);
+        settings.humidity_setting.target = DEFAULT_TARGET_HUMIDITY;
+        settings.humidity_setting.threshold = DEFAULT_HUMIDITY_THRESHOLD;
+        settings.changeover_lockout = DEFAULT_CHANGEOVER_LOCKOUT;
+
+        for (uint8_t n = 1; n <= MAX_CMPLX_TEMPS; n++) {
+            bench_get_current_setting(out, settings, n);
+        }
+        for (uint8_t n = 0; n < MAX_CMPLX_TEMPS; n++) {
+            bench_add_temp_setting(out, settings, n);
+        }
+        bench_to_string(out);
+        fill_schedule(settings, MAX_CMPLX_TEMPS);
+        for (uint8_t mode = Mode::Off; mode <= Mode::Auto; mode++) {
+            settings.mode = (Mode) mode;
+            bench_update_call(out, settings);
+        }
+        bench_print_standby(out, settings);
+    }
+
+    private:
+    int lcd_cols;
+    int lcd_rows;
+    Keypad* keypad;
+    RTC_DS1307* rtc;
+    RuntimeLog* runtime_log;
+    SensorGroup* sensors;
+
+    // Fills the schedule with `n` settings, one a minute starting at 00:01
+    static void fill_schedule(Settings& settings, uint8_t n) {
+        settings.temp_settings.clear();
+        for (uint8_t i = 0; i < n; i++) {
+            TempSetting ts(20, 24, 0L, (long) i + 1);
+            settings.temp_settings.push_back(ts);
+        }
+    }
+
+    static void report(Print& out, const __FlashStringHelper* name, int param, unsigned long elapsed_us, unsigned long iterations, unsigned long bytes_allocated, unsigned long i2c_bytes) {
+        out.print(F("{\"bench\":\""));
+        out.print(name);
+        out.print(F("\",\"param\":"));
+        out.print(param);
+        out.print(F(",\"iterations\":"));
+        out.print(iterations);
+        out.print(F(",\"ns_per_op\":"));
+        // Split so elapsed_us * 1000 can't overflow an unsigned long on long runs
+        out.print(elapsed_us / iterations * 1000 + elapsed_us % iterations * 1000 / iterations);
+        out.print(F(",\"bytes_allocated_per_op\":"));
+        out.print(bytes_allocated / iterations);
+        out.print(F(",\"i2c_bytes_per_op\":"));
+        out.print(i2c_bytes / iterations);
+        out.println('}');
+    }
+
+    // Worst case lookup: the current time is before every setting, so the whole schedule is scanned
+    void bench_get_current_setting(Print& out, Settings& settings, uint8_t n) {
+        fill_schedule(settings, n);
+        DateTime midnight(2022, 1, 1, 0, 0, 0);
+        unsigned long allocated = host_bytes_allocated;
+        volatile long sink = 0;
+        unsigned long start = micros();
+        for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+            sink += settings.get_current_setting(&midnight)->start_time();
+        }
+        unsigned long elapsed = micros() - start;
+        report(out, F("get_current_setting"), n, elapsed, BENCH_ITERATIONS, host_bytes_allocated - allocated, 0);
+    }
+
+    // Inserts a setting into the middle of a schedule of `n` settings
+    void bench_add_temp_setting(Print& out, Settings& settings, uint8_t n) {
+        unsigned long allocated = 0;
+        unsigned long elapsed = 0;
+        for (unsigned long i = 0; i < BENCH_ADD_ITERATIONS; i++) {
+            fill_schedule(settings, n);
+            unsigned long allocated_start = host_bytes_allocated;
+            unsigned long start = micros();
+            settings.add_temp_setting(21, 25, 0, n / 2);
+            elapsed += micros() - start;
+            allocated += host_bytes_allocated - allocated_start;
+        }
+        report(out, F("add_temp_setting"), n, elapsed, BENCH_ADD_ITERATIONS, allocated, 0);
+    }
+
+    void bench_to_string(Print& out) {
+        TempSetting ts(20.5, 24, 12L, 34L);
+        unsigned long allocated = host_bytes_allocated;
+        volatile unsigned int sink = 0;
+        unsigned long start = micros();
+        for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+            sink += ts.to_string().length();
+        }
+        unsigned long elapsed = micros() - start;
+        report(out, F("to_string"), 0, elapsed, BENCH_ITERATIONS, host_bytes_allocated - allocated, 0);
+    }
+
+    /*
+    Every call starts from Off with the compressor ready and no changeover lockout, with a reading that
+    switches Heat, Cool and Auto on. Off and Fan don't compare temperatures at all.
+    Only the update_call itself is timed and counted, not resetting the state in between.
+    */
+    void bench_update_call(Print& out, Settings& settings) {
+        TempMgr temp_mgr(&settings, rtc, RelayPins {HEAT_PIN, COOL_PIN, FAN_PIN});
+        temp_mgr.begin();
+        TempMgrState ready;
+        temp_mgr.save_state(ready);
+        ready.running_mode = Mode::Off;
+        ready.last_active_mode = Mode::Off;
+        ready.compressor_off_age = MIN_COMPRESSOR_OFF_TIME;
+        unsigned long allocated = 0;
+        unsigned long i2c_bytes = 0;
+        unsigned long elapsed = 0;
+        for (unsigned long i = 0; i < BENCH_ITERATIONS; i++) {
+            temp_mgr.restore_state(ready);
+            bool cold = settings.mode == Mode::Heat || (settings.mode == Mode::Auto && i % 2);
+            unsigned long allocated_start = host_bytes_allocated;
+            unsigned long i2c_start = Wire.bytes;
+            unsigned long start = micros();
+            temp_mgr.update_call(cold ? 10 : 30, 50);
+            elapsed += micros() - start;
+            i2c_bytes += Wire.bytes - i2c_start;
+            allocated += host_bytes_allocated - allocated_start;
+        }
+        report(out, F("update_call"), settings.mode, elapsed, BENCH_ITERATIONS, allocated, i2c_bytes);
+    }
+
+    // Renders the main standby screen
+    void bench_print_standby(Print& out, Settings& settings) {
+        settings.mode = Mode::Auto;
+        TempMgr temp_mgr(&settings, rtc, RelayPins {HEAT_PIN, COOL_PIN, FAN_PIN});
+        MenuDisplay lcd(0x27, lcd_cols, lcd_rows);
+        Menu menu(lcd_cols, lcd_rows, &lcd, keypad, &settings, rtc, &temp_mgr, runtime_log);
+        lcd.init();
+        menu.begin();
+        unsigned long allocated = host_bytes_allocated;
+        unsigned long i2c_start = Wire.bytes;
+        unsigned long start = micros();
+        for (unsigned long i = 0; i < BENCH_STANDBY_ITERATIONS; i++) {
+            menu.print_standby(sensors);
+        }
+        unsigned long elapsed = micros() - start;
+        report(out, F("print_standby"), 0, elapsed, BENCH_STANDBY_ITERATIONS, host_bytes_allocated - allocated, Wire.bytes - i2c_start);
+    }
+};
+
+#endif
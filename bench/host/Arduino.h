@@ -0,0 +1,353 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/*
+Just enough of the Arduino core to build the sketch headers natively for the benchmarks
+String allocates through malloc / realloc like the AVR core does, so the allocation counter sees it
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+
+#define DEC 10
+#define HEX 16
+
+// ATmega328P EEPROM
+#define E2END 0x3FF
+
+#define bit(b) (1UL << (b))
+#define bitRead(value, b) (((value) >> (b)) & 0x01)
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define PSTR(s) (s)
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+
+// Stack pointer, only read by memory.h
+extern uintptr_t SP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+class String {
+    public:
+    String() {
+        init();
+    }
+    String(const char* str) {
+        init();
+        copy(str, strlen(str));
+    }
+    String(const __FlashStringHelper* str) {
+        init();
+        copy((const char*) str, strlen((const char*) str));
+    }
+    String(const String& other) {
+        init();
+        copy(other.buffer, other.len);
+    }
+    explicit String(char c) {
+        init();
+        copy(&c, 1);
+    }
+    explicit String(unsigned char value, unsigned char base = 10) {
+        init();
+        format("%u", (unsigned int) value);
+    }
+    explicit String(int value, unsigned char base = 10) {
+        init();
+        format("%d", value);
+    }
+    explicit String(unsigned int value, unsigned char base = 10) {
+        init();
+        format("%u", value);
+    }
+    explicit String(long value, unsigned char base = 10) {
+        init();
+        format("%ld", value);
+    }
+    explicit String(unsigned long value, unsigned char base = 10) {
+        init();
+        format("%lu", value);
+    }
+    explicit String(float value, unsigned char decimals = 2) {
+        init();
+        format("%.*f", (int) decimals, (double) value);
+    }
+    explicit String(double value, unsigned char decimals = 2) {
+        init();
+        format("%.*f", (int) decimals, value);
+    }
+    ~String() {
+        free(buffer);
+    }
+
+    String& operator=(const String& other) {
+        if (this != &other) {
+            copy(other.buffer, other.len);
+        }
+        return *this;
+    }
+    String& operator=(const char* str) {
+        copy(str, strlen(str));
+        return *this;
+    }
+
+    bool reserve(unsigned int size) {
+        if (buffer && capacity >= size) {
+            return true;
+        }
+        char* grown = (char*) realloc(buffer, size + 1);
+        if (!grown) {
+            return false;
+        }
+        if (!buffer) {
+            grown[0] = '\0';
+        }
+        buffer = grown;
+        capacity = size;
+        return true;
+    }
+
+    unsigned int length() const {
+        return len;
+    }
+    const char* c_str() const {
+        return buffer ? buffer : "";
+    }
+
+    String& operator+=(const String& other) {
+        append(other.c_str(), other.len);
+        return *this;
+    }
+    String& operator+=(const char* str) {
+        append(str, strlen(str));
+        return *this;
+    }
+    String& operator+=(const __FlashStringHelper* str) {
+        return *this += (const char*) str;
+    }
+    String& operator+=(char c) {
+        append(&c, 1);
+        return *this;
+    }
+
+    bool operator==(const String& other) const {
+        return strcmp(c_str(), other.c_str()) == 0;
+    }
+    bool operator==(const char* str) const {
+        return strcmp(c_str(), str) == 0;
+    }
+    bool operator!=(const char* str) const {
+        return !(*this == str);
+    }
+    char operator[](unsigned int idx) const {
+        return idx < len ? buffer[idx] : '\0';
+    }
+
+    String substring(unsigned int start) const {
+        return substring(start, len);
+    }
+    String substring(unsigned int start, unsigned int end) const {
+        String out;
+        if (end > len) {
+            end = len;
+        }
+        if (start < end) {
+            out.copy(buffer + start, end - start);
+        }
+        return out;
+    }
+    long toInt() const {
+        return atol(c_str());
+    }
+    float toFloat() const {
+        return atof(c_str());
+    }
+
+    private:
+    char* buffer;
+    unsigned int capacity;
+    unsigned int len;
+
+    void init() {
+        buffer = NULL;
+        capacity = 0;
+        len = 0;
+    }
+    void copy(const char* str, unsigned int n) {
+        if (!reserve(n)) {
+            return;
+        }
+        memmove(buffer, str, n);
+        len = n;
+        buffer[len] = '\0';
+    }
+    void append(const char* str, unsigned int n) {
+        if (!reserve(len + n)) {
+            return;
+        }
+        memmove(buffer + len, str, n);
+        len += n;
+        buffer[len] = '\0';
+    }
+    template <class T>
+    void format(const char* fmt, int decimals, T value) {
+        char tmp[48];
+        snprintf(tmp, sizeof(tmp), fmt, decimals, value);
+        copy(tmp, strlen(tmp));
+    }
+    template <class T>
+    void format(const char* fmt, T value) {
+        char tmp[48];
+        snprintf(tmp, sizeof(tmp), fmt, value);
+        copy(tmp, strlen(tmp));
+    }
+};
+
+inline String operator+(const String& a, const String& b) {
+    String out(a);
+    out += b;
+    return out;
+}
+inline String operator+(const String& a, const char* b) {
+    String out(a);
+    out += b;
+    return out;
+}
+inline String operator+(const char* a, const String& b) {
+    String out(a);
+    out += b;
+    return out;
+}
+inline String operator+(const String& a, char b) {
+    String out(a);
+    out += b;
+    return out;
+}
+inline String operator+(char a, const String& b) {
+    String out(a);
+    out += b;
+    return out;
+}
+
+class Print {
+    public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+    size_t write(const char* str) {
+        return write((const uint8_t*) str, strlen(str));
+    }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper* str) {
+        return write((const char*) str);
+    }
+    size_t print(const String& str) {
+        return write(str.c_str());
+    }
+    size_t print(const char* str) {
+        return write(str);
+    }
+    size_t print(char c) {
+        return write((uint8_t) c);
+    }
+    size_t print(unsigned char value, int base = DEC) {
+        return print((unsigned long) value, base);
+    }
+    size_t print(int value, int base = DEC) {
+        return print((long) value, base);
+    }
+    size_t print(unsigned int value, int base = DEC) {
+        return print((unsigned long) value, base);
+    }
+    size_t print(long value, int base = DEC) {
+        return printf_to(base == HEX ? "%lx" : "%ld", value);
+    }
+    size_t print(unsigned long value, int base = DEC) {
+        return printf_to(base == HEX ? "%lx" : "%lu", value);
+    }
+    size_t print(double value, int decimals = 2) {
+        if (isnan(value)) {
+            return write("nan");
+        }
+        char tmp[48];
+        snprintf(tmp, sizeof(tmp), "%.*f", decimals, value);
+        return write(tmp);
+    }
+
+    size_t println() {
+        return write("\r\n");
+    }
+    template <class T>
+    size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <class T>
+    size_t println(T value, int format) {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+    private:
+    template <class T>
+    size_t printf_to(const char* fmt, T value) {
+        char tmp[24];
+        snprintf(tmp, sizeof(tmp), fmt, value);
+        return write(tmp);
+    }
+};
+
+// Serial goes nowhere, the sketch headers' logging would only bury the results
+class HardwareSerial : public Print {
+    public:
+    void begin(unsigned long baud) {}
+    int available() {
+        return 0;
+    }
+    int read() {
+        return -1;
+    }
+    virtual size_t write(uint8_t c) {
+        return 1;
+    }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef HOST_ARXCONTAINER_H
+#define HOST_ARXCONTAINER_H
+
+#include <Arduino.h>
+
+// ArxContainer as it builds on AVR: fixed capacity storage inside the object, no heap
+#define ARX_VECTOR_DEFAULT_SIZE 16
+
+namespace arx {
+
+template <class A, class B>
+struct pair {
+    A first;
+    B second;
+};
+
+template <class T, size_t N = ARX_VECTOR_DEFAULT_SIZE>
+class vector {
+    public:
+    class iterator {
+        public:
+        iterator(T* base, size_t i) {
+            this->base = base;
+            this->i = i;
+        }
+        size_t index() const {
+            return i;
+        }
+        iterator operator+(size_t n) const {
+            return iterator(base, i + n);
+        }
+        T& operator*() const {
+            return base[i];
+        }
+
+        private:
+        T* base;
+        size_t i;
+    };
+
+    vector() {
+        n = 0;
+    }
+
+    void reserve(size_t size) {}
+
+    void push_back(const T& value) {
+        if (n < N) {
+            buf[n++] = value;
+        }
+    }
+
+    void erase(const iterator& it) {
+        for (size_t i = it.index(); i + 1 < n; i++) {
+            buf[i] = buf[i + 1];
+        }
+        if (it.index() < n) {
+            n--;
+        }
+    }
+
+    void clear() {
+        n = 0;
+    }
+
+    size_t size() const {
+        return n;
+    }
+    T* data() {
+        return buf;
+    }
+    T& operator[](size_t i) {
+        return buf[i];
+    }
+    const T& operator[](size_t i) const {
+        return buf[i];
+    }
+    iterator begin() {
+        return iterator(buf, 0);
+    }
+    iterator end() {
+        return iterator(buf, n);
+    }
+
+    private:
+    T buf[N];
+    size_t n;
+};
+
+}
+
+#endif
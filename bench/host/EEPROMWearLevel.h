@@ -0,0 +1,45 @@
+#ifndef HOST_EEPROMWEARLEVEL_H
+#define HOST_EEPROMWEARLEVEL_H
+
+#include <Arduino.h>
+
+/*
+EEPROMwl kept in RAM, one slot per index
+The wear leveling itself doesn't matter to the benchmarks, only that get() returns what put() stored
+*/
+#define HOST_EEPROM_INDEXES 32
+#define HOST_EEPROM_SLOT_BYTES 32
+
+class EEPROMWearLevel {
+    public:
+    EEPROMWearLevel() {
+        memset(data, 0xff, sizeof(data));
+    }
+
+    void begin(uint8_t layout_version, uint8_t amount_of_indexes) {}
+
+    template <class T>
+    T& get(int idx, T& t) {
+        static_assert(sizeof(T) <= HOST_EEPROM_SLOT_BYTES, "host EEPROM slot too small");
+        if (idx >= 0 && idx < HOST_EEPROM_INDEXES) {
+            memcpy((void*) &t, data[idx], sizeof(T));
+        }
+        return t;
+    }
+
+    template <class T>
+    const T& put(int idx, const T& t) {
+        static_assert(sizeof(T) <= HOST_EEPROM_SLOT_BYTES, "host EEPROM slot too small");
+        if (idx >= 0 && idx < HOST_EEPROM_INDEXES) {
+            memcpy(data[idx], (const void*) &t, sizeof(T));
+        }
+        return t;
+    }
+
+    private:
+    uint8_t data[HOST_EEPROM_INDEXES][HOST_EEPROM_SLOT_BYTES];
+};
+
+extern EEPROMWearLevel EEPROMwl;
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef HOST_KEYPAD_H
+#define HOST_KEYPAD_H
+
+#include <Arduino.h>
+
+#define NO_KEY '\0'
+#define makeKeymap(x) ((char*) x)
+
+// A keypad nobody presses
+class Keypad {
+    public:
+    Keypad(char* user_keymap, byte* row, byte* col, byte num_rows, byte num_cols) {}
+
+    char getKey() {
+        return NO_KEY;
+    }
+
+    bool getKeys() {
+        return false;
+    }
+
+    void setDebounceTime(unsigned int debounce) {}
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef HOST_LIQUIDCRYSTAL_I2C_H
+#define HOST_LIQUIDCRYSTAL_I2C_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+/*
+LiquidCrystal_I2C sending over the counting Wire
+Every LCD byte goes out as two nibbles through the PCF8574, each written with enable high and then low,
+the same as the real library, so the bus bytes counted match what the panel would get
+*/
+
+#define LCD_CLEARDISPLAY 0x01
+#define LCD_RETURNHOME 0x02
+#define LCD_DISPLAYCONTROL 0x08
+#define LCD_SETCGRAMADDR 0x40
+#define LCD_SETDDRAMADDR 0x80
+
+#define LCD_DISPLAYON 0x04
+#define LCD_BLINKON 0x01
+
+#define LCD_BACKLIGHT 0x08
+#define LCD_NOBACKLIGHT 0x00
+
+#define En 0x04
+#define Rs 0x01
+
+class LiquidCrystal_I2C : public Print {
+    public:
+    LiquidCrystal_I2C(uint8_t addr, uint8_t cols, uint8_t rows) {
+        this->addr = addr;
+        this->cols = cols;
+        this->rows = rows;
+        backlight_val = LCD_NOBACKLIGHT;
+        display_control = LCD_DISPLAYON;
+    }
+
+    void init() {
+        Wire.begin();
+        expanderWrite(backlight_val);
+        command(LCD_DISPLAYCONTROL | display_control);
+        clear();
+        home();
+    }
+
+    void clear() {
+        command(LCD_CLEARDISPLAY);
+    }
+
+    void home() {
+        command(LCD_RETURNHOME);
+    }
+
+    void setCursor(uint8_t col, uint8_t row) {
+        static const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+        if (row >= rows) {
+            row = rows - 1;
+        }
+        command(LCD_SETDDRAMADDR | (col + row_offsets[row]));
+    }
+
+    void blink_on() {
+        display_control |= LCD_BLINKON;
+        command(LCD_DISPLAYCONTROL | display_control);
+    }
+
+    void blink_off() {
+        display_control &= ~LCD_BLINKON;
+        command(LCD_DISPLAYCONTROL | display_control);
+    }
+
+    void backlight() {
+        backlight_val = LCD_BACKLIGHT;
+        expanderWrite(0);
+    }
+
+    void noBacklight() {
+        backlight_val = LCD_NOBACKLIGHT;
+        expanderWrite(0);
+    }
+
+    void createChar(uint8_t location, uint8_t charmap[]) {
+        command(LCD_SETCGRAMADDR | ((location & 0x7) << 3));
+        for (int i = 0; i < 8; i++) {
+            write(charmap[i]);
+        }
+    }
+
+    virtual size_t write(uint8_t value) {
+        send(value, Rs);
+        return 1;
+    }
+    using Print::write;
+
+    private:
+    uint8_t addr;
+    uint8_t cols;
+    uint8_t rows;
+    uint8_t backlight_val;
+    uint8_t display_control;
+
+    void command(uint8_t value) {
+        send(value, 0);
+    }
+
+    void send(uint8_t value, uint8_t mode) {
+        write4bits((value & 0xf0) | mode);
+        write4bits(((value << 4) & 0xf0) | mode);
+    }
+
+    void write4bits(uint8_t value) {
+        expanderWrite(value);
+        pulseEnable(value);
+    }
+
+    void pulseEnable(uint8_t data) {
+        expanderWrite(data | En);
+        expanderWrite(data & ~En);
+    }
+
+    void expanderWrite(uint8_t data) {
+        Wire.beginTransmission(addr);
+        Wire.write(data | backlight_val);
+        Wire.endTransmission();
+    }
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef HOST_RTCLIB_H
+#define HOST_RTCLIB_H
+
+#include <Arduino.h>
+#include <time.h>
+#include <Wire.h>
+
+#define DS1307_ADDRESS 0x68
+
+// Seconds from 1970-01-01 to 2000-01-01
+#define SECONDS_FROM_1970_TO_2000 946684800UL
+
+class DateTime {
+    public:
+    DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000) {
+        set_unixtime(t);
+    }
+
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0) {
+        yOff = year >= 2000 ? year - 2000 : year;
+        m = month;
+        d = day;
+        hh = hour;
+        mm = min;
+        ss = sec;
+    }
+
+    uint16_t year() const {
+        return 2000 + yOff;
+    }
+    uint8_t month() const {
+        return m;
+    }
+    uint8_t day() const {
+        return d;
+    }
+    uint8_t hour() const {
+        return hh;
+    }
+    uint8_t minute() const {
+        return mm;
+    }
+    uint8_t second() const {
+        return ss;
+    }
+
+    // 0 is Sunday, 2000-01-01 was a Saturday
+    uint8_t dayOfTheWeek() const {
+        return (days_from_civil(year(), m, d) - days_from_civil(2000, 1, 1) + 6) % 7;
+    }
+
+    uint32_t unixtime() const {
+        long days = days_from_civil(year(), m, d);
+        return (uint32_t) days * 86400UL + hh * 3600UL + mm * 60UL + ss;
+    }
+
+    private:
+    uint8_t yOff;
+    uint8_t m;
+    uint8_t d;
+    uint8_t hh;
+    uint8_t mm;
+    uint8_t ss;
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar
+    static long days_from_civil(long y, unsigned month, unsigned day) {
+        y -= month <= 2;
+        long era = (y >= 0 ? y : y - 399) / 400;
+        unsigned yoe = (unsigned) (y - era * 400);
+        unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + (long) doe - 719468;
+    }
+
+    void set_unixtime(uint32_t t) {
+        ss = t % 60;
+        t /= 60;
+        mm = t % 60;
+        t /= 60;
+        hh = t % 24;
+        long z = t / 24 + 719468;
+        long era = z / 146097;
+        unsigned doe = (unsigned) (z - era * 146097);
+        unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        long y = (long) yoe + era * 400;
+        unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        yOff = (y + (m <= 2)) - 2000;
+    }
+};
+
+enum Ds1307SqwPinMode {
+    DS1307_OFF = 0x00,
+    DS1307_ON = 0x80,
+    DS1307_SquareWave1HZ = 0x10
+};
+
+/*
+A DS1307 that reads the host clock
+isrunning() and now() put the same traffic on the counting Wire as the real chip: the register address
+write, then a 1 or 7 byte read
+*/
+class RTC_DS1307 {
+    public:
+    RTC_DS1307() {
+        offset = 0;
+    }
+
+    bool begin() {
+        Wire.begin();
+        return true;
+    }
+
+    uint8_t isrunning() {
+        read_registers(0, 1);
+        return 1;
+    }
+
+    DateTime now() {
+        read_registers(0, 7);
+        return DateTime((uint32_t) (time(NULL) + offset));
+    }
+
+    void adjust(const DateTime& dt) {
+        offset = (long) dt.unixtime() - (long) time(NULL);
+    }
+
+    void writeSqwPinMode(Ds1307SqwPinMode mode) {
+        Wire.beginTransmission(DS1307_ADDRESS);
+        Wire.write(7);
+        Wire.write(mode);
+        Wire.endTransmission();
+    }
+
+    private:
+    long offset;
+
+    void read_registers(uint8_t reg, uint8_t n) {
+        Wire.beginTransmission(DS1307_ADDRESS);
+        Wire.write(reg);
+        Wire.endTransmission();
+        Wire.requestFrom((uint8_t) DS1307_ADDRESS, n);
+        while (Wire.available()) {
+            Wire.read();
+        }
+    }
+};
+
+#endif
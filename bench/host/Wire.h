@@ -0,0 +1,58 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+/*
+A bus with nothing on it that counts the bytes that would have gone over I2C
+Every transmission costs its address byte, reads also cost the bytes requested
+*/
+class TwoWire {
+    public:
+    TwoWire() {
+        bytes = 0;
+    }
+
+    void begin() {}
+
+    void beginTransmission(uint8_t addr) {
+        bytes++;
+    }
+
+    uint8_t endTransmission(bool stop = true) {
+        return 0;
+    }
+
+    size_t write(uint8_t value) {
+        bytes++;
+        return 1;
+    }
+
+    uint8_t requestFrom(uint8_t addr, uint8_t quantity) {
+        bytes += 1 + quantity;
+        available_bytes = quantity;
+        return quantity;
+    }
+
+    int available() {
+        return available_bytes;
+    }
+
+    int read() {
+        if (available_bytes == 0) {
+            return -1;
+        }
+        available_bytes--;
+        return 0;
+    }
+
+    // Bytes put on the bus so far, addresses included
+    unsigned long bytes;
+
+    private:
+    uint8_t available_bytes;
+};
+
+extern TwoWire Wire;
+
+#endif
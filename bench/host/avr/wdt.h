@@ -0,0 +1,10 @@
+#ifndef HOST_AVR_WDT_H
+#define HOST_AVR_WDT_H
+
+#define WDTO_4S 8
+
+inline void wdt_enable(int timeout) {}
+inline void wdt_disable() {}
+inline void wdt_reset() {}
+
+#endif
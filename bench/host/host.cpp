@@ -0,0 +1,64 @@
+/*
+Definitions behind the host stubs
+malloc and realloc are wrapped at link time (-Wl,--wrap) so every allocation the sketch headers make is counted
+*/
+#include <chrono>
+#include <stdlib.h>
+
+#include <Arduino.h>
+#include <EEPROMWearLevel.h>
+#include <Wire.h>
+
+#include "host.h"
+
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_realloc(void* ptr, size_t size);
+
+unsigned long host_bytes_allocated = 0;
+
+extern "C" void* __wrap_malloc(size_t size) {
+    host_bytes_allocated += size;
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+    host_bytes_allocated += size;
+    return __real_realloc(ptr, size);
+}
+
+HardwareSerial Serial;
+TwoWire Wire;
+EEPROMWearLevel EEPROMwl;
+
+/*
+The AVR linker symbols, heap end and stack pointer read by memory.h
+Only defined so the sketch headers link, none of the benchmarks read them
+__data_start and __bss_start already come from the host's C runtime and linker script
+*/
+char __data_end;
+char __bss_end;
+char __noinit_start;
+char __noinit_end;
+char __heap_start;
+char* __brkval = NULL;
+struct __freelist* __flp = NULL;
+uintptr_t SP = 0;
+
+static const std::chrono::steady_clock::time_point host_start = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - host_start).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - host_start).count();
+}
+
+void delay(unsigned long ms) {}
+void delayMicroseconds(unsigned int us) {}
+void pinMode(uint8_t pin, uint8_t mode) {}
+void digitalWrite(uint8_t pin, uint8_t value) {}
+
+int digitalRead(uint8_t pin) {
+    return HIGH;
+}
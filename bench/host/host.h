@@ -0,0 +1,7 @@
+#ifndef HOST_H
+#define HOST_H
+
+// Bytes requested from malloc / realloc since start-up, counted by the wrappers in host.cpp
+extern unsigned long host_bytes_allocated;
+
+#endif
@@ -0,0 +1,51 @@
+/*
+Host benchmark runner, prints the results from bench.h to stdout as JSON lines
+*/
+#include <Arduino.h>
+#include <DHT.h>
+#include <Keypad.h>
+#include <RTClib.h>
+
+#include "bench.h"
+
+#define LCD_COLS 16
+#define LCD_ROWS 2
+
+class StdoutPrint : public Print {
+    public:
+    virtual size_t write(uint8_t c) {
+        putchar(c);
+        return 1;
+    }
+    using Print::write;
+};
+
+char KEYMAP[4][4] = {
+    {'7', '8', '9', 'U'},
+    {'4', '5', '6', 'D'},
+    {'1', '2', '3', 'M'},
+    {'.', '0', 'B', 'K'}
+};
+byte KEYPAD_ROW_PINS[4] = {9, 8, 7, 6};
+byte KEYPAD_COL_PINS[4] = {13, 11, 12, 10};
+
+int main() {
+    Keypad keypad(makeKeymap(KEYMAP), KEYPAD_ROW_PINS, KEYPAD_COL_PINS, (byte) 4, (byte) 4);
+    DHT dht(2, DHT22);
+    DHT* sensors[] = {&dht};
+    const float weights[] = {1};
+    SensorGroup sensor_group(sensors, weights, 1, AggregateMode::Average);
+    sensor_group.begin();
+    sensor_group.read_temperature();
+
+    RTC_DS1307 rtc;
+    rtc.begin();
+    rtc.adjust(DateTime(2022, 1, 1, 12, 0, 0));
+    RuntimeLog runtime_log(&rtc);
+    runtime_log.begin();
+
+    StdoutPrint out;
+    Benchmarks benchmarks(LCD_COLS, LCD_ROWS, &keypad, &rtc, &runtime_log, &sensor_group);
+    benchmarks.run(out);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+/*
+Key replay for scripted UI tests, driven with the KEYS / SCREEN / EXPECT / EXPECTSET / DRYRUN serial commands
+Only compiled in when KEY_REPLAY is defined, so production builds don't carry the queue or let serial drive the UI
+Recorded sequences and the script that streams them to the board are in replay/
+*/
+#ifdef KEY_REPLAY
+
+#include <Keypad.h>
+
+// Maximum number of queued replay keys
+#define KEY_QUEUE_LEN 32
+
+/*
+Key source shared by the standby loop and the menu
+Keys queued with `queue_keys` (e.g. a recorded sequence sent over serial) are returned before
+the keypad is read. For each replayed key the time until the UI has finished rendering (`rendered`,
+or the next `get_key` at the latest) and the control ticks missed in between are reported as a JSON line.
+*/
+class KeyInput {
+    public:
+    KeyInput(Keypad* keypad) {
+        this->keypad = keypad;
+        queue_start = 0;
+        queue_len = 0;
+        pending_key = NO_KEY;
+        report_out = NULL;
+        missed_ticks = NULL;
+    }
+
+    // Sets where replay latency is reported and the missed control tick counter to report with it
+    void set_report(Print* out, const unsigned long* missed_ticks) {
+        report_out = out;
+        this->missed_ticks = missed_ticks;
+    }
+
+    // Queues `keys` for replay. Returns `false` if they don't all fit.
+    bool queue_keys(const char* keys) {
+        if (queue_len + strlen(keys) > KEY_QUEUE_LEN) {
+            return false;
+        }
+        for (; *keys; keys++) {
+            queue[(queue_start + queue_len) % KEY_QUEUE_LEN] = *keys;
+            queue_len++;
+        }
+        return true;
+    }
+
+    // Returns the next queued key or the key pressed on the keypad, NO_KEY if there's neither
+    char get_key() {
+        rendered();
+        if (queue_len == 0) {
+            return keypad->getKey();
+        }
+        char key = queue[queue_start];
+        queue_start = (queue_start + 1) % KEY_QUEUE_LEN;
+        queue_len--;
+
+        pending_key = key;
+        key_time = micros();
+        key_missed_ticks = missed_ticks ? *missed_ticks : 0;
+        return key;
+    }
+
+    // Call once the UI has finished drawing its response to the last key. Reports the replayed key's latency.
+    void rendered() {
+        if (pending_key == NO_KEY) {
+            return;
+        }
+        unsigned long latency = micros() - key_time;
+        char key = pending_key;
+        pending_key = NO_KEY;
+        if (!report_out) {
+            return;
+        }
+        report_out->print(F("{\"key\":\""));
+        report_out->print(key);
+        report_out->print(F("\",\"latency_us\":"));
+        report_out->print(latency);
+        report_out->print(F(",\"missed_ticks\":"));
+        report_out->print(missed_ticks ? *missed_ticks - key_missed_ticks : 0);
+        report_out->println('}');
+    }
+
+    // Returns `true` if the key last returned by `get_key` came from the replay queue
+    bool last_key_replayed() const {
+        return pending_key != NO_KEY;
+    }
+
+    private:
+    Keypad* keypad;
+    char queue[KEY_QUEUE_LEN];
+    uint8_t queue_start;
+    uint8_t queue_len;
+
+    Print* report_out;
+    const unsigned long* missed_ticks;
+    // Last replayed key that hasn't had its latency reported yet
+    char pending_key;
+    unsigned long key_time;
+    unsigned long key_missed_ticks;
+};
+
+/*
+Checks whether any line printed to it equals `expected`
+Used to assert on text output, e.g. Settings::print_settings
+*/
+class LineMatcher : public Print {
+    public:
+    LineMatcher(const char* expected) {
+        this->expected = expected;
+        matched = false;
+        pos = 0;
+        mismatch = false;
+    }
+
+    virtual size_t write(uint8_t c) {
+        if (c == '\r') {
+            return 1;
+        }
+        if (c == '\n') {
+            if (!mismatch && expected[pos] == '\0') {
+                matched = true;
+            }
+            pos = 0;
+            mismatch = false;
+            return 1;
+        }
+        if (!mismatch && expected[pos] == c) {
+            pos++;
+        } else {
+            mismatch = true;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    bool matched;
+
+    private:
+    const char* expected;
+    size_t pos;
+    bool mismatch;
+};
+
+#endif
+
+#endif
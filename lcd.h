@@ -0,0 +1,94 @@
+#ifndef LCD_H
+#define LCD_H
+
+#include <LiquidCrystal_I2C.h>
+
+// The screen copy is only needed for key replay tests
+#ifdef KEY_REPLAY
+
+// Size of the screen copy kept by ShadowLCD
+#define SHADOW_COLS 16
+#define SHADOW_ROWS 2
+
+/*
+An LCD that keeps a copy of what's on screen
+NOTE: clear() and setCursor() hide the base class versions, so they're only tracked
+when called through a ShadowLCD pointer
+*/
+class ShadowLCD : public LiquidCrystal_I2C {
+    public:
+    ShadowLCD(uint8_t addr, uint8_t cols, uint8_t rows) : LiquidCrystal_I2C(addr, cols, rows) {
+        clear_shadow();
+    }
+
+    void clear() {
+        clear_shadow();
+        LiquidCrystal_I2C::clear();
+    }
+
+    void setCursor(uint8_t col, uint8_t row) {
+        cursor_col = col;
+        cursor_row = row;
+        LiquidCrystal_I2C::setCursor(col, row);
+    }
+
+    virtual size_t write(uint8_t value) {
+        if (cursor_col < SHADOW_COLS && cursor_row < SHADOW_ROWS) {
+            shadow[cursor_row][cursor_col] = value;
+        }
+        cursor_col++;
+        return LiquidCrystal_I2C::write(value);
+    }
+    using Print::write;
+
+    // Returns `true` if `row` shows `text`, followed only by blanks
+    bool row_equals(uint8_t row, const char* text) const {
+        if (row >= SHADOW_ROWS) {
+            return false;
+        }
+        size_t len = strlen(text);
+        if (len > SHADOW_COLS) {
+            return false;
+        }
+        for (uint8_t col = 0; col < SHADOW_COLS; col++) {
+            char expected = col < len ? text[col] : ' ';
+            if (shadow[row][col] != expected) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Prints the screen contents, one line per row
+    void print_shadow(Print& out) const {
+        for (uint8_t row = 0; row < SHADOW_ROWS; row++) {
+            out.print('|');
+            for (uint8_t col = 0; col < SHADOW_COLS; col++) {
+                out.print(shadow[row][col]);
+            }
+            out.println('|');
+        }
+    }
+
+    private:
+    char shadow[SHADOW_ROWS][SHADOW_COLS];
+    uint8_t cursor_col;
+    uint8_t cursor_row;
+
+    void clear_shadow() {
+        memset(shadow, ' ', sizeof(shadow));
+        cursor_col = 0;
+        cursor_row = 0;
+    }
+};
+
+// The display type the UI draws to. The screen copy only stays right if it sees every call.
+typedef ShadowLCD MenuDisplay;
+
+#else
+
+typedef LiquidCrystal_I2C MenuDisplay;
+
+#endif
+
+#endif
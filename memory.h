@@ -0,0 +1,125 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+// Byte the free RAM between the heap and the stack is painted with at boot
+#define STACK_CANARY 0xC5
+// Shorter canary runs are taken to be stack data that happens to match STACK_CANARY
+#define STACK_CANARY_MIN_RUN 4
+// Bytes right below the stack pointer left unpainted for `paint_stack`'s own frame
+#define STACK_PAINT_MARGIN 16
+// How often the stack high-watermark is checked in ms
+#define MEMORY_CHECK_INTERVAL 10000UL
+// Warn over serial once the free stack has dropped below this many bytes
+#define STACK_WARN_THRESHOLD 64
+
+// Symbols from the linker script and avr-libc's malloc
+extern char* __brkval;
+extern char __heap_start;
+extern char __data_start;
+extern char __data_end;
+extern char __bss_start;
+extern char __bss_end;
+extern char __noinit_start;
+extern char __noinit_end;
+
+struct __freelist {
+    size_t sz;
+    struct __freelist* nx;
+};
+extern struct __freelist* __flp;
+
+unsigned long _last_memory_check = 0;
+bool _stack_warned = false;
+// Bounds of the area painted by `paint_stack`
+uint8_t* _paint_start = NULL;
+uint8_t* _paint_end = NULL;
+
+// Returns the current end of the heap
+char* heap_end() {
+    return __brkval ? __brkval : &__heap_start;
+}
+
+// Fills the free RAM between the heap and the stack with STACK_CANARY
+void paint_stack() {
+    _paint_start = (uint8_t*) heap_end();
+    _paint_end = (uint8_t*) SP - STACK_PAINT_MARGIN;
+    for (uint8_t* p = _paint_start; p < _paint_end; p++) {
+        *p = STACK_CANARY;
+    }
+}
+
+/*
+Returns the fewest bytes that have been free between the heap and the stack since `paint_stack`
+Scans down from the top of the painted area past what the stack has used, then counts the canary bytes below it.
+The heap end can't be used as the bottom, free() lowers it again and leaves stale chunks above it.
+*/
+size_t stack_free_min() {
+    uint8_t* p = _paint_end;
+    size_t n = 0;
+    while (p > _paint_start && n < STACK_CANARY_MIN_RUN) {
+        while (p > _paint_start && p[-1] != STACK_CANARY) {
+            p--;
+        }
+        n = 0;
+        while (p > _paint_start && p[-1] == STACK_CANARY) {
+            p--;
+            n++;
+        }
+    }
+    return n;
+}
+
+// Returns the total free RAM: the gap between the heap and the stack plus the heap's free list
+size_t free_memory() {
+    size_t total = (char*) SP - heap_end();
+    for (struct __freelist* block = __flp; block; block = block->nx) {
+        total += block->sz;
+    }
+    return total;
+}
+
+// Returns the largest single block malloc could hand out right now
+size_t largest_free_block() {
+    size_t largest = (char*) SP - heap_end();
+    for (struct __freelist* block = __flp; block; block = block->nx) {
+        if (block->sz > largest) {
+            largest = block->sz;
+        }
+    }
+    return largest;
+}
+
+// Prints the static RAM sections and the current heap / stack usage
+void print_memory_report(Print& out) {
+    out.print(F("data: "));
+    out.print(&__data_end - &__data_start);
+    out.print(F(", bss: "));
+    out.print(&__bss_end - &__bss_start);
+    out.print(F(", noinit: "));
+    out.println(&__noinit_end - &__noinit_start);
+    out.print(F("heap used: "));
+    out.print(heap_end() - &__heap_start);
+    out.print(F(", free: "));
+    out.print(free_memory());
+    out.print(F(", largest free block: "));
+    out.println(largest_free_block());
+    out.print(F("stack free min: "));
+    out.println(stack_free_min());
+}
+
+// Checks the stack high-watermark every MEMORY_CHECK_INTERVAL and warns once if it gets too low
+void check_memory(Print& out) {
+    if (millis() - _last_memory_check < MEMORY_CHECK_INTERVAL) {
+        return;
+    }
+    _last_memory_check = millis();
+    size_t stack_free = stack_free_min();
+    if (stack_free < STACK_WARN_THRESHOLD && !_stack_warned) {
+        _stack_warned = true;
+        out.print(F("WARNING: only "));
+        out.print(stack_free);
+        out.println(F(" bytes of stack have been left free"));
+    }
+}
+
+#endif
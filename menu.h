@@ -2,31 +2,60 @@
 #ifndef MENU_H
 #define MENU_H
 
+#include <avr/wdt.h>
 #include <ArxContainer.h>
-#include <LiquidCrystal_I2C.h>
 #include <Keypad.h>
 #include <RTClib.h>
 
+#include "lcd.h"
+#include "memory.h"
+#include "runtime.h"
+#include "sensors.h"
 #include "settings.h"
 #include "temp_mgr.h"
 
 
-const char* SUB_MENUS[7] = {
+const char* SUB_MENUS[10] = {
     "MODE",
     "CTRL MODE",
     "TIME",
     "SELECT UNITS",
     "ADD TEMP SET",
     "DEL TEMP SET",
-    "EDIT TEMP SET"
+    "EDIT TEMP SET",
+    "HUMIDITY",
+    "AUTO LOCKOUT",
+    "DIAGNOSTICS"
 };
 
-#define N_SUB_MENUS 7
+#define N_SUB_MENUS 10
+
+// Standby screens, cycled through with the 'B' key
+enum StandbyPage {
+    Main = 0,
+    Humidity = 1,
+    Runtime = 2
+};
+
+#define N_STANDBY_PAGES 3
+
+// Custom character slot for the "1/2" glyph used in temperature setting lists
+#define HALF_CHAR 1
+byte HALF_GLYPH[8] = {
+    0b01000,
+    0b11000,
+    0b01000,
+    0b01000,
+    0b00110,
+    0b00001,
+    0b00010,
+    0b00111
+};
 
 class Menu {
     public:
     Settings* settings;
-    Menu(int lcd_cols, int lcd_rows, LiquidCrystal_I2C* display, Keypad* keypad, Settings* settings, RTC_DS1307* rtc, TempMgr* temp_mgr) {
+    Menu(int lcd_cols, int lcd_rows, MenuDisplay* display, Keypad* keypad, Settings* settings, RTC_DS1307* rtc, TempMgr* temp_mgr, RuntimeLog* runtime_log) {
         this->display = display;
         this->lcd_cols = lcd_cols;
         this->lcd_rows = lcd_rows;
@@ -36,11 +65,68 @@ class Menu {
         this->rtc = rtc;
         this->settings = settings;
         this->temp_mgr = temp_mgr;
+        this->runtime_log = runtime_log;
+
+        standby_page = StandbyPage::Main;
+        idle_task = NULL;
+        key_source = NULL;
+#ifdef KEY_REPLAY
+        dry_run = false;
+#endif
+    }
+
+    // Loads the custom characters. The display has to be initialized first.
+    void begin() {
+        display->createChar(HALF_CHAR, HALF_GLYPH);
+    }
+
+    // Sets a function that's run while waiting for a key, so control keeps running inside the menu
+    void set_idle_task(void (*idle_task)()) {
+        this->idle_task = idle_task;
+    }
+
+    // Sets a function keys are read from instead of the keypad, e.g. one that also tracks activity for the backlight
+    void set_key_source(char (*key_source)()) {
+        this->key_source = key_source;
+    }
+
+#ifdef KEY_REPLAY
+    // In a dry run (e.g. while replaying a test sequence) the RTC and EEPROM are left alone
+    void set_dry_run(bool dry_run) {
+        this->dry_run = dry_run;
+    }
+#endif
+
+    // Writes the settings to EEPROM, unless this is a dry run
+    void save_settings() {
+#ifdef KEY_REPLAY
+        if (dry_run) {
+            Serial.println(F("Dry run, settings not saved"));
+            return;
+        }
+#endif
+        settings->save_settings();
     }
 
-    // Prints standby menu
-    void print_standby(float current_temp) {
+    // Prints the current standby screen
+    void print_standby(SensorGroup* sensors) {
         display->clear();
+        if (standby_page == StandbyPage::Humidity) {
+            print_standby_humidity(sensors);
+        } else if (standby_page == StandbyPage::Runtime) {
+            print_standby_runtime();
+        } else {
+            print_standby_main(sensors->temperature());
+        }
+    }
+
+    // Switches to the next standby screen
+    void next_standby_page() {
+        standby_page = (StandbyPage) wrap(0, N_STANDBY_PAGES, standby_page + 1);
+    }
+
+    // Prints the main standby screen
+    void print_standby_main(float current_temp) {
         DateTime now = rtc->now();
         // Print current temperature
         // TODO: Make this flash when climate control is running
@@ -77,12 +163,18 @@ class Menu {
         }
 
         // Print target temp
+        const TempSetting* tgt_temp = settings->get_current_setting(&now);
         display->setCursor(0, 1);
-        display->print(F("TGT"));
-        tempstr = String(settings->get_current_setting(&now)->target_temp());
-        // NOTE: The -1 might have to change depending on how the degrees symbol changes the positioning
-        //display->setCursor(lcd_cols / 2 - tempstr.length() / 2 - 1, 1);
-        display->setCursor(4, 1);
+        if (mode == Mode::Auto) {
+            // Auto mode shows both setpoints in place of the "TGT" label
+            tempstr = String(tgt_temp->heat_temp(), 1) + '-' + String(tgt_temp->cool_temp(), 1);
+        } else {
+            display->print(F("TGT"));
+            tempstr = String(tgt_temp->target_temp(mode));
+            // NOTE: The -1 might have to change depending on how the degrees symbol changes the positioning
+            //display->setCursor(lcd_cols / 2 - tempstr.length() / 2 - 1, 1);
+            display->setCursor(4, 1);
+        }
         display->print(tempstr);
         // TODO: Add custom 'degrees' symbol with `display->createChar`
         // display->write((byte) 0);
@@ -108,6 +200,49 @@ class Menu {
         }
     }
 
+    // Prints the humidity standby screen
+    void print_standby_humidity(SensorGroup* sensors) {
+        // Print current and target humidity
+        display->setCursor(0, 0);
+        display->print(F("RH "));
+        display->print(String(sensors->humidity(), 0));
+        display->print('%');
+        display->setCursor(lcd_cols - 8, 0);
+        display->print(F("TGT "));
+        display->print(String(settings->humidity_setting.target));
+        display->print('%');
+
+        // Print heat index
+        display->setCursor(0, 1);
+        display->print(F("FEELS "));
+        display->print(String(sensors->heat_index()));
+        display->print('C');
+    }
+
+    /*
+    Prints the runtime standby screen
+    Top row is today's runtime, bottom row the last 7 days', both in hours
+    */
+    void print_standby_runtime() {
+        const DayRuntime& today = runtime_log->get_today();
+        // Today gets one decimal unless that doesn't fit
+        String today_str = runtime_row(F("1d"), today.outputs[HeatOutput].minutes, today.outputs[CoolOutput].minutes, today.outputs[FanOutput].minutes, 1);
+        if (today_str.length() > (unsigned int) lcd_cols) {
+            today_str = runtime_row(F("1d"), today.outputs[HeatOutput].minutes, today.outputs[CoolOutput].minutes, today.outputs[FanOutput].minutes, 0);
+        }
+        display->setCursor(0, 0);
+        display->print(today_str);
+
+        display->setCursor(0, 1);
+        display->print(runtime_row(
+            F("7d"),
+            runtime_log->get_week_total(HeatOutput).minutes,
+            runtime_log->get_week_total(CoolOutput).minutes,
+            runtime_log->get_week_total(FanOutput).minutes,
+            0
+        ));
+    }
+
     void run_menu() {
         int8_t submenu = select_submenu(SUB_MENUS, N_SUB_MENUS);
         // Back
@@ -129,9 +264,15 @@ class Menu {
             menu_del_temp_setting();
         } else if (submenu == 6) {
             menu_edit_temp_setting();
+        } else if (submenu == 7) {
+            menu_set_humidity();
+        } else if (submenu == 8) {
+            menu_set_changeover_lockout();
+        } else if (submenu == 9) {
+            menu_diagnostics();
         }
         // Write updated settings to EEPROM
-        settings->save_settings();
+        save_settings();
     }
 
     void show_error(const String& msg) {
@@ -147,13 +288,21 @@ class Menu {
 
     private:
     TempMgr* temp_mgr;
-    LiquidCrystal_I2C* display;
+    RuntimeLog* runtime_log;
+    MenuDisplay* display;
     int lcd_cols;
     int lcd_rows;
 
     RTC_DS1307* rtc;
     Keypad* keypad;
 
+    StandbyPage standby_page;
+    void (*idle_task)();
+    char (*key_source)();
+#ifdef KEY_REPLAY
+    bool dry_run;
+#endif
+
     void menu_set_mode() {
         const char* smenus[5] = {
             "OFF",
@@ -189,6 +338,15 @@ class Menu {
         uint8_t minute = time_pair.second;
         // Year, month and day are currently placeholders
         DateTime dt(2022, 18, 7, hour, minute);
+#ifdef KEY_REPLAY
+        if (dry_run) {
+            Serial.print(F("Dry run, RTC not set to "));
+            Serial.print(hour);
+            Serial.print(':');
+            Serial.println(minute);
+            return;
+        }
+#endif
         rtc->adjust(dt);
     }
 
@@ -205,10 +363,10 @@ class Menu {
         long hour = time_pair.first;
         long minute = time_pair.second;
 
-        String temp_str = user_query_temperature(F("Enter temp.:"));
-        float temp = temp_str.toFloat();
+        float heat_temp = user_query_temperature(F("Heat temp.:")).toFloat();
+        float cool_temp = user_query_temperature(F("Cool temp.:")).toFloat();
 
-        int status = settings->add_temp_setting(temp, hour, minute);
+        int status = settings->add_temp_setting(heat_temp, cool_temp, hour, minute);
         if (status) {
             show_error(F("Max Temp Sets"));
         }
@@ -222,7 +380,7 @@ class Menu {
             return;
         }
         //Confirmation dialog
-        bool confirmation = user_confirm("Delete " + settings->temp_settings[selection].to_string() + '?');
+        bool confirmation = user_confirm("Delete " + settings->temp_settings[selection].time_string() + '?');
         if (confirmation) {
             settings->delete_temp_setting(selection);
         }
@@ -242,30 +400,89 @@ class Menu {
         long hour = time_pair.first;
         long minute = time_pair.second;
 
-        String temp_str = user_query_temperature(F("Eneter temp.:"));
-        float temp = temp_str.toFloat();
+        float heat_temp = user_query_temperature(F("Heat temp.:")).toFloat();
+        float cool_temp = user_query_temperature(F("Cool temp.:")).toFloat();
 
         // Delete the old temp setting and create a new one
         settings->delete_temp_setting(selection);
-        int status = settings->add_temp_setting(temp, hour, minute);
+        int status = settings->add_temp_setting(heat_temp, cool_temp, hour, minute);
+    }
+
+    // Sets the target humidity and the dehumidify threshold
+    void menu_set_humidity() {
+        // An empty entry keeps the current value
+        String humidity_str = user_query_temperature(F("Target humidity:"), '%');
+        if (humidity_str.length() > 0) {
+            long humidity = humidity_str.toInt();
+            if (humidity < 0 || humidity > 100) {
+                show_error(F("Invalid humidity"));
+                return;
+            }
+            settings->humidity_setting.target = humidity;
+        }
+
+        // How far above the target the humidity may go before cooling runs longer to dehumidify
+        String threshold_str = user_query_temperature(F("Humid threshold:"), '%');
+        if (threshold_str.length() > 0) {
+            long threshold = threshold_str.toInt();
+            if (threshold < 1 || threshold > MAX_HUMIDITY_THRESHOLD) {
+                show_error(F("Invalid threshold"));
+                return;
+            }
+            settings->humidity_setting.threshold = threshold;
+        }
+    }
+
+    // Sets how many minutes Auto mode waits before switching between heating and cooling
+    void menu_set_changeover_lockout() {
+        String lockout_str = user_query_temperature(F("Lockout minutes:"), 'm');
+        if (lockout_str.length() == 0) {
+            return;
+        }
+        long lockout = lockout_str.toInt();
+        if (lockout < 0 || lockout > MAX_CHANGEOVER_LOCKOUT) {
+            show_error(F("Invalid lockout"));
+            return;
+        }
+        settings->changeover_lockout = lockout;
+    }
+
+    // Shows free RAM, the largest free block (B) and the stack high-watermark until a key is pressed
+    void menu_diagnostics() {
+        display->clear();
+        display->setCursor(0, 0);
+        // Both fit 4 digits with 2 KB of RAM, so "FREE 1234 B1234" is at most 15 columns
+        display->print(F("FREE "));
+        display->print(free_memory());
+        display->print(F(" B"));
+        display->print(largest_free_block());
+        display->setCursor(0, 1);
+        display->print(F("STACK MIN "));
+        display->print(stack_free_min());
+        wait_for_key();
     }
 
     // Query the user to select a temp setting
     int user_select_temp_setting() {
-        // Load tempsettings into submenus array
-        const char** submenus = new const char*[settings->temp_settings.size()];
         if (settings->temp_settings.size() == 0) {
             show_error(F("No temp settings"));
             return -1;
         }
-        for (size_t i = 0; i < settings->temp_settings.size(); i++) {
+        // Load tempsettings into submenus array
+        size_t n_settings = settings->temp_settings.size();
+        const char** submenus = new const char*[n_settings];
+        for (size_t i = 0; i < n_settings; i++) {
             const TempSetting& ts = settings->temp_settings[i];
-            const String setting_str = ts.to_string();
-            submenus[i] = new char[setting_str.length()];
+            const String setting_str = ts.to_string(HALF_CHAR);
+            submenus[i] = new char[setting_str.length() + 1];
             strcpy((char*) submenus[i], setting_str.c_str());
         }
         // Get selection from user
-        int8_t selection = select_submenu(submenus, settings->temp_settings.size());
+        int8_t selection = select_submenu(submenus, n_settings);
+        for (size_t i = 0; i < n_settings; i++) {
+            delete[] submenus[i];
+        }
+        delete[] submenus;
         return selection;
     }
 
@@ -276,7 +493,7 @@ class Menu {
         display->blink_on();
         display->setCursor(0, 0);
         while (true) {
-            char key = keypad->waitForKey();
+            char key = wait_for_key();
             if (key >= '0' && key <= '9') {
                 menu_idx = key - '0' - 1;
             }
@@ -298,14 +515,14 @@ class Menu {
         }
     }
 
-    // Queries the user for a temperature
-    String user_query_temperature(const String& query) {
+    // Queries the user for a temperature (or another value shown with `unit`)
+    String user_query_temperature(const String& query, char unit = 'C') {
         display->blink_on();
         String user_input = F("");
 
         while (true) {
-            user_query_temperature_update_display(query, user_input);
-            char key = keypad->waitForKey();
+            user_query_temperature_update_display(query, user_input, unit);
+            char key = wait_for_key();
             if (key == 'B') {
                 if (user_input.length() > 0) {
                     user_input = user_input.substring(0, user_input.length() - 1);
@@ -324,7 +541,7 @@ class Menu {
     }
 
     // Updates the display when querying the user for a temperature input
-    void user_query_temperature_update_display(const String& query, const String& user_input) {
+    void user_query_temperature_update_display(const String& query, const String& user_input, char unit) {
         // Print query
         display->clear();
         display->setCursor(lcd_cols / 2 - query.length() / 2, 0);
@@ -333,7 +550,7 @@ class Menu {
         // Print current user input
         display->setCursor(lcd_cols / 2 - (user_input.length() + 1) / 2, 1);
         display->print(user_input);
-        display->print('C');
+        display->print(unit);
 
         // Set cursor location for blinking
         display->setCursor(lcd_cols / 2 + user_input.length() / 2, 1);
@@ -346,7 +563,7 @@ class Menu {
 
         while (true) {
             user_query_time_update_display(query, user_input);
-            char key = keypad->waitForKey();
+            char key = wait_for_key();
             if (key == 'B') {
                 if (user_input.length() > 0) {
                     user_input = user_input.substring(0, user_input.length() - 1);
@@ -462,7 +679,7 @@ class Menu {
         display->print(confirm_dialog);
         char key = 0;
         while (key != 'K' && key != 'B') {
-            key = keypad->waitForKey();
+            key = wait_for_key();
         }
         if (key == 'K') {
             return true;
@@ -476,10 +693,43 @@ class Menu {
         for (int row = 0; row < lcd_rows; row++) {
             display->setCursor(0, row);
             uint8_t option_n = wrap(0, n_options, row + scroll_pos);
-            display->print(String(option_n + 1) + ". " + menu_options[option_n]);
+            // Two digit numbers drop the space so a 13 character option still fits
+            display->print(String(option_n + 1) + (option_n < 9 ? ". " : ".") + menu_options[option_n]);
         }
     }
 
+    /*
+    Waits for a key press while keeping the watchdog fed and running the idle task
+    Keys are checked before the idle task, so a key that's already waiting is picked up as soon as rendering finishes
+    */
+    char wait_for_key() {
+        while (true) {
+            wdt_reset();
+            char key = key_source ? key_source() : keypad->getKey();
+            if (key != NO_KEY) {
+                return key;
+            }
+            if (idle_task) {
+                idle_task();
+            }
+        }
+    }
+
+    /*
+    Returns "<label> H<heat> C<cool> F<fan>" with the runtimes converted from minutes to hours
+    With whole hours a row always fits 16 columns, since heating and cooling share the same 24 / 168 hours
+    */
+    String runtime_row(const __FlashStringHelper* label, uint16_t heat_min, uint16_t cool_min, uint16_t fan_min, uint8_t decimals) {
+        String row = label;
+        row += F(" H");
+        row += String(heat_min / 60.0, decimals);
+        row += F(" C");
+        row += String(cool_min / 60.0, decimals);
+        row += F(" F");
+        row += String(fan_min / 60.0, decimals);
+        return row;
+    }
+
     // Wraps a number between s and e
     int wrap(int s, int e, int n) {
         if (n >= e) {
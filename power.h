@@ -0,0 +1,175 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <avr/sleep.h>
+#include <LiquidCrystal_I2C.h>
+
+// Turn the backlight off after this many ms without a key press
+#define BACKLIGHT_TIMEOUT 30000UL
+// Stay awake for this many ms after a key press so the keypad can see it being released
+#define KEYPAD_AWAKE_TIME 500UL
+
+// DS1307 square wave output. Has to be on port C (A0 - A5) so it gets its own pin change interrupt
+#define RTC_SQW_PIN A0
+
+// Set from the pin change interrupts
+volatile bool _power_key_wake = false;
+volatile bool _power_rtc_wake = false;
+
+// Keypad rows are on ports B and D, the RTC square wave on port C
+ISR(PCINT0_vect) {
+    _power_key_wake = true;
+}
+ISR(PCINT1_vect) {
+    _power_rtc_wake = true;
+}
+ISR(PCINT2_vect) {
+    _power_key_wake = true;
+}
+
+/*
+Idles the MCU between scheduled work and turns the backlight off after inactivity
+The MCU wakes on a keypad press, an RTC square wave edge, serial input or once the requested time has passed.
+*/
+class PowerMgr {
+    public:
+    PowerMgr(LiquidCrystal_I2C* display, byte* row_pins, byte* col_pins, uint8_t n_rows, uint8_t n_cols) {
+        this->display = display;
+        this->row_pins = row_pins;
+        this->col_pins = col_pins;
+        this->n_rows = n_rows;
+        this->n_cols = n_cols;
+        backlight_on = true;
+        last_key = 0;
+        reset_stats();
+    }
+
+    // Enables the pin change interrupts for the keypad rows and the RTC square wave
+    void begin() {
+        for (uint8_t i = 0; i < n_rows; i++) {
+            enable_pin_change_interrupt(row_pins[i]);
+        }
+        pinMode(RTC_SQW_PIN, INPUT_PULLUP);
+        enable_pin_change_interrupt(RTC_SQW_PIN);
+        set_sleep_mode(SLEEP_MODE_IDLE);
+    }
+
+    /*
+    Idles for up to `duration` ms or until woken by a key press, the RTC or serial input
+    Returns immediately while a key press is still being handled
+    */
+    void idle(unsigned long duration) {
+        if (millis() - last_key < KEYPAD_AWAKE_TIME) {
+            return;
+        }
+        unsigned long start = millis();
+        unsigned long start_us = micros();
+        // Cleared before the columns are driven, so a key that's already held down still counts as a wake-up
+        _power_key_wake = false;
+        // Drive the columns low so a pressed key pulls its row low and raises an interrupt
+        // The keypad library puts them back into INPUT on its next scan
+        for (uint8_t i = 0; i < n_cols; i++) {
+            pinMode(col_pins[i], OUTPUT);
+            digitalWrite(col_pins[i], LOW);
+        }
+        while (millis() - start < duration && !Serial.available()) {
+            // Interrupts are only re-enabled right before sleeping so a wake-up can't be missed
+            noInterrupts();
+            if (_power_key_wake || _power_rtc_wake || key_held()) {
+                interrupts();
+                break;
+            }
+            sleep_enable();
+            interrupts();
+            sleep_cpu();
+            sleep_disable();
+        }
+        for (uint8_t i = 0; i < n_cols; i++) {
+            pinMode(col_pins[i], INPUT);
+        }
+        idle_ms += (micros() - start_us) / 1000.0;
+    }
+
+    /*
+    Call on every key press. Turns the backlight back on if it was off.
+    Returns `false` if the key only woke the backlight and shouldn't be acted on.
+    */
+    bool key_pressed() {
+        last_key = millis();
+        if (!backlight_on) {
+            display->backlight();
+            backlight_on = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Turns the backlight off once BACKLIGHT_TIMEOUT has passed since the last key press
+    void update_backlight() {
+        if (backlight_on && millis() - last_key >= BACKLIGHT_TIMEOUT) {
+            display->noBacklight();
+            backlight_on = false;
+        }
+    }
+
+    // Returns `true` once for every RTC square wave edge
+    bool rtc_ticked() {
+        if (!_power_rtc_wake) {
+            return false;
+        }
+        _power_rtc_wake = false;
+        return true;
+    }
+
+    // Returns the percentage of time spent awake since the stats were last reset
+    float active_percent() {
+        unsigned long total_ms = millis() - stats_start;
+        if (total_ms == 0) {
+            return 100;
+        }
+        return constrain(100.0 * (1.0 - idle_ms / total_ms), 0.0, 100.0);
+    }
+
+    void reset_stats() {
+        stats_start = millis();
+        idle_ms = 0;
+    }
+
+    // Prints the active time percentage and resets the measurement window
+    void print_stats(Print& out) {
+        out.print(F("Active time: "));
+        out.print(active_percent());
+        out.print(F("% over "));
+        out.print(millis() - stats_start);
+        out.println(F("ms"));
+        reset_stats();
+    }
+
+    private:
+    LiquidCrystal_I2C* display;
+    byte* row_pins;
+    byte* col_pins;
+    uint8_t n_rows;
+    uint8_t n_cols;
+    bool backlight_on;
+    unsigned long last_key;
+    unsigned long stats_start;
+    float idle_ms;
+
+    // Returns `true` if a row is pulled low, i.e. a key is held down while the columns are driven low
+    bool key_held() {
+        for (uint8_t i = 0; i < n_rows; i++) {
+            if (digitalRead(row_pins[i]) == LOW) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void enable_pin_change_interrupt(uint8_t pin) {
+        *digitalPinToPCMSK(pin) |= bit(digitalPinToPCMSKbit(pin));
+        *digitalPinToPCICR(pin) |= bit(digitalPinToPCICRbit(pin));
+    }
+};
+
+#endif
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Streams recorded key sequences to a board built with KEY_REPLAY and checks their EXPECT / EXPECTSET lines
+
+Every non-blank line of a sequence that doesn't start with '#' is sent as a serial command. After KEYS the script
+waits until every key has been rendered, after EXPECT / EXPECTSET until the board answers PASS or FAIL.
+Stops at the first failure and exits with 1.
+
+The sequences run in a dry run, so the RTC and EEPROM are left alone. The settings they change in RAM stay
+until the board is reset. 03 - 05 build on each other and expect an empty schedule.
+
+usage: replay.py <port> [sequence ...]    (defaults to every *.txt next to this script, in order)
+needs pyserial
+"""
+
+import argparse
+import glob
+import json
+import os
+import sys
+import time
+
+import serial
+
+BAUD = 9600
+# SERIAL_CMD_LEN - 1 and KEY_QUEUE_LEN in a KEY_REPLAY build
+MAX_CMD_LEN = 39
+MAX_KEYS = 32
+# Seconds to wait for a reply. show_error alone holds the board for 2 s.
+REPLY_TIMEOUT = 10
+# The Uno resets when the port is opened
+BOOT_TIME = 3
+
+
+class ReplayError(Exception):
+    pass
+
+
+def read_line(port, deadline):
+    while time.monotonic() < deadline:
+        line = port.readline()
+        if line:
+            return line.decode("ascii", "replace").rstrip("\r\n")
+    return None
+
+
+def send(port, cmd):
+    if len(cmd) > MAX_CMD_LEN:
+        raise ReplayError("command longer than {} characters: {}".format(MAX_CMD_LEN, cmd))
+    port.write(cmd.encode("ascii") + b"\n")
+
+
+def run_keys(port, cmd, stats):
+    keys = cmd[len("KEYS "):]
+    if len(keys) > MAX_KEYS:
+        raise ReplayError("more than {} keys: {}".format(MAX_KEYS, cmd))
+    send(port, cmd)
+    deadline = time.monotonic() + REPLY_TIMEOUT
+    rendered = 0
+    while rendered < len(keys):
+        line = read_line(port, deadline)
+        if line is None:
+            raise ReplayError("timed out after {} of {} keys: {}".format(rendered, len(keys), cmd))
+        if line == "Key queue full":
+            raise ReplayError("key queue full: " + cmd)
+        if not line.startswith('{"key"'):
+            continue
+        report = json.loads(line)
+        stats["keys"] += 1
+        stats["max_latency_us"] = max(stats["max_latency_us"], report["latency_us"])
+        stats["missed_ticks"] += report["missed_ticks"]
+        rendered += 1
+
+
+def run_expect(port, cmd):
+    send(port, cmd)
+    deadline = time.monotonic() + REPLY_TIMEOUT
+    while True:
+        line = read_line(port, deadline)
+        if line is None:
+            raise ReplayError("timed out: " + cmd)
+        if line == "PASS":
+            return
+        if line == "FAIL":
+            # The board follows FAIL with the screen or the settings
+            details = []
+            detail_deadline = time.monotonic() + 1
+            while True:
+                detail = read_line(port, detail_deadline)
+                if detail is None:
+                    break
+                details.append(detail)
+            raise ReplayError("failed: " + cmd + "".join("\n    " + d for d in details))
+
+
+def run_sequence(port, path):
+    stats = {"keys": 0, "max_latency_us": 0, "missed_ticks": 0}
+    with open(path) as sequence:
+        for line_no, line in enumerate(sequence, 1):
+            # Leading spaces are part of EXPECT's text, only the line end is dropped
+            cmd = line.rstrip("\r\n")
+            if not cmd.strip() or cmd.startswith("#"):
+                continue
+            try:
+                if cmd.startswith("KEYS "):
+                    run_keys(port, cmd, stats)
+                elif cmd.startswith("EXPECT"):
+                    run_expect(port, cmd)
+                else:
+                    send(port, cmd)
+                    time.sleep(0.1)
+            except ReplayError as e:
+                raise ReplayError("{}:{}: {}".format(path, line_no, e))
+    return stats
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Replays recorded key sequences over serial")
+    parser.add_argument("port", help="serial port, e.g. /dev/ttyACM0")
+    parser.add_argument("sequences", nargs="*", help="sequence files, every *.txt next to this script by default")
+    args = parser.parse_args()
+    sequences = args.sequences or sorted(glob.glob(os.path.join(here, "*.txt")))
+
+    port = serial.Serial(args.port, BAUD, timeout=0.1)
+    time.sleep(BOOT_TIME)
+    port.reset_input_buffer()
+
+    try:
+        for path in sequences:
+            stats = run_sequence(port, path)
+            print("PASS {}: {} keys, max latency {} us, {} missed ticks".format(
+                os.path.basename(path), stats["keys"], stats["max_latency_us"], stats["missed_ticks"]))
+    except ReplayError as e:
+        print("FAIL " + str(e))
+        return 1
+    finally:
+        port.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
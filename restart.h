@@ -0,0 +1,143 @@
+#ifndef RESTART_H
+#define RESTART_H
+
+#include <avr/wdt.h>
+
+#include "runtime.h"
+#include "sensors.h"
+#include "temp_mgr.h"
+#include "zones.h"
+
+// NOTE: Has to change whenever RuntimeSnapshot does, the noinit RAM also survives uploading new firmware
+#define SNAPSHOT_MAGIC 0x7E58
+#define WATCHDOG_TIMEOUT WDTO_4S
+/*
+Warm restarts in a row that may restore the snapshot without a control tick completing in between
+After that the relays stay off, so a reset loop (e.g. a hung I2C bus in setup) can't hold a relay on forever
+*/
+#define MAX_WARM_RESTARTS 2
+
+// Everything needed to resume one zone's control after a reset
+struct ZoneSnapshot {
+    TempMgrState control;
+    float temp;
+    float humidity;
+};
+
+struct RuntimeSnapshot {
+    uint16_t magic;
+    ZoneSnapshot zones[N_ZONES];
+    // Today's runtime counters, including whatever hasn't been flushed to EEPROM yet
+    DayRuntime runtime;
+    uint8_t checksum;
+};
+
+/*
+Kept in .noinit so they're left alone by the C runtime on reset
+Both are garbage after a power-on reset, which the magic number and checksum catch
+*/
+RuntimeSnapshot _runtime_snapshot __attribute__((section(".noinit")));
+uint8_t _reset_flags __attribute__((section(".noinit")));
+// Warm restarts since a control tick last completed. Only meaningful while the snapshot is valid.
+uint8_t _warm_restarts __attribute__((section(".noinit")));
+
+// Set if a valid snapshot was thrown away because of MAX_WARM_RESTARTS
+bool _snapshot_discarded = false;
+
+/*
+Runs before the C runtime initializes RAM
+The watchdog stays enabled with its shortest timeout after a watchdog reset, so it has to be
+turned off before anything else runs. MCUSR is cleared so the next reset's cause isn't mixed in.
+NOTE: Some bootloaders clear MCUSR themselves, in which case the reset cause reads as 0
+*/
+void _save_reset_flags() __attribute__((naked, used, section(".init3")));
+void _save_reset_flags() {
+    _reset_flags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+uint8_t _snapshot_checksum(const RuntimeSnapshot& snapshot) {
+    const uint8_t* bytes = (const uint8_t*) &snapshot;
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < offsetof(RuntimeSnapshot, checksum); i++) {
+        checksum = (checksum << 1 | checksum >> 7) ^ bytes[i];
+    }
+    return checksum;
+}
+
+// Saves every zone's control state and the runtime counters into the no-init snapshot
+template <uint8_t N>
+void save_snapshot(ZoneTable<N>& zones, const RuntimeLog& runtime_log) {
+    for (uint8_t i = 0; i < N; i++) {
+        ZoneSnapshot& zone_snapshot = _runtime_snapshot.zones[i];
+        zones[i].temp_mgr->save_state(zone_snapshot.control);
+        zone_snapshot.temp = zones[i].sensors->temperature();
+        zone_snapshot.humidity = zones[i].sensors->humidity();
+    }
+    _runtime_snapshot.runtime = runtime_log.get_today();
+    // The restart made it through setup and a full control tick, so it's no longer suspect
+    if (zones.ticks > 0) {
+        _warm_restarts = 0;
+    }
+    _runtime_snapshot.magic = SNAPSHOT_MAGIC;
+    _runtime_snapshot.checksum = _snapshot_checksum(_runtime_snapshot);
+}
+
+/*
+Sets up every zone's relays, then restores their control state if a valid snapshot
+survived the reset. Returns `true` on a warm restart.
+Falls back to a cold start with every relay off after MAX_WARM_RESTARTS restarts that never reached a control tick.
+*/
+template <uint8_t N>
+bool restore_snapshot(ZoneTable<N>& zones) {
+    zones.begin();
+    if (_runtime_snapshot.magic != SNAPSHOT_MAGIC || _runtime_snapshot.checksum != _snapshot_checksum(_runtime_snapshot)) {
+        _warm_restarts = 0;
+        return false;
+    }
+    if (_warm_restarts >= MAX_WARM_RESTARTS) {
+        _warm_restarts = 0;
+        _runtime_snapshot.magic = 0;
+        _snapshot_discarded = true;
+        return false;
+    }
+    _warm_restarts++;
+    for (uint8_t i = 0; i < N; i++) {
+        const ZoneSnapshot& zone_snapshot = _runtime_snapshot.zones[i];
+        zones[i].temp_mgr->restore_state(zone_snapshot.control);
+        zones[i].sensors->restore(zone_snapshot.temp, zone_snapshot.humidity);
+    }
+    return true;
+}
+
+// Returns the runtime counters from before the reset. Only valid after `restore_snapshot` returned `true`.
+const DayRuntime* snapshot_runtime() {
+    return &_runtime_snapshot.runtime;
+}
+
+// Prints the reset cause from MCUSR
+void print_reset_cause(Print& out) {
+    out.print(F("Reset cause:"));
+    if (_reset_flags & bit(PORF)) {
+        out.print(F(" power-on"));
+    }
+    if (_reset_flags & bit(EXTRF)) {
+        out.print(F(" external"));
+    }
+    if (_reset_flags & bit(BORF)) {
+        out.print(F(" brownout"));
+    }
+    if (_reset_flags & bit(WDRF)) {
+        out.print(F(" watchdog"));
+    }
+    if (!_reset_flags) {
+        out.print(F(" unknown"));
+    }
+    out.println();
+    if (_snapshot_discarded) {
+        out.println(F("Too many warm restarts without a control tick, started cold with the relays off"));
+    }
+}
+
+#endif
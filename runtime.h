@@ -0,0 +1,184 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <EEPROMWearLevel.h>
+#include <RTClib.h>
+
+#include "settings.h"
+
+// How often the current day's counters are written to EEPROM in ms
+#define RUNTIME_FLUSH_INTERVAL 900000UL
+
+#define SECONDS_PER_DAY 86400UL
+
+// Outputs that have their runtime tracked, used as bit indexes into TempMgr::outputs()
+enum Output {
+    HeatOutput = 0,
+    CoolOutput = 1,
+    FanOutput = 2
+};
+
+#define N_OUTPUTS 3
+
+struct OutputRuntime {
+    uint16_t minutes;
+    uint16_t cycles;
+};
+
+// One day's record in the EEPROM ring
+struct DayRuntime {
+    // Days since 1970 (from the RTC)
+    uint16_t day;
+    OutputRuntime outputs[N_OUTPUTS];
+};
+
+// Each index has to hold the largest record written to it, which caps N_ZONES (at 2 on an Uno)
+static_assert(max(sizeof(TempSetting), sizeof(DayRuntime)) <= EEPROM_INDEX_BYTES, "Too many zones, the EEPROM indexes are too small for their records");
+
+/*
+Accumulates per-output runtime and on-cycles in RAM and periodically flushes them
+to a ring of N_RUNTIME_DAYS wear-leveled EEPROM records, one per day
+NOTE: Settings::begin has to be called first since it initializes EEPROMwl
+*/
+class RuntimeLog {
+    public:
+    RuntimeLog(RTC_DS1307* rtc) {
+        this->rtc = rtc;
+        last_outputs = 0;
+        last_update = 0;
+        last_flush = 0;
+    }
+
+    /*
+    Restores today's counters from EEPROM if they were already started
+    After a warm restart `resumed` is the record from before the reset, which may be ahead of the last flush,
+    and `outputs` the outputs that were resumed, so they aren't counted as new cycles
+    */
+    void begin(const DayRuntime* resumed = NULL, uint8_t outputs = 0) {
+        memset(&today, 0, sizeof(today));
+        today.day = current_day();
+        DayRuntime stored;
+        EEPROMwl.get(slot_idx(today.day), stored);
+        if (stored.day == today.day) {
+            today = stored;
+        }
+        if (resumed && resumed->day == today.day) {
+            today = *resumed;
+        }
+        last_outputs = outputs;
+        for (uint8_t i = 0; i < N_OUTPUTS; i++) {
+            run_ms[i] = (unsigned long) today.outputs[i].minutes * 60000UL;
+        }
+        last_update = millis();
+        last_flush = millis();
+    }
+
+    /*
+    Accumulates runtime for the outputs that were on since the last call
+    `outputs` is a bitmask of `Output`s that are currently on
+    */
+    void update(uint8_t outputs) {
+        unsigned long now_ms = millis();
+        unsigned long elapsed = now_ms - last_update;
+        last_update = now_ms;
+
+        uint16_t day = current_day();
+        if (day != today.day) {
+            // Close out the old day and start a fresh record
+            flush();
+            memset(&today, 0, sizeof(today));
+            memset(run_ms, 0, sizeof(run_ms));
+            today.day = day;
+        }
+
+        for (uint8_t i = 0; i < N_OUTPUTS; i++) {
+            if (bitRead(last_outputs, i)) {
+                run_ms[i] += elapsed;
+            } else if (bitRead(outputs, i)) {
+                today.outputs[i].cycles++;
+            }
+            today.outputs[i].minutes = run_ms[i] / 60000UL;
+        }
+        last_outputs = outputs;
+
+        if (now_ms - last_flush >= RUNTIME_FLUSH_INTERVAL) {
+            flush();
+        }
+    }
+
+    // Writes today's counters to EEPROM
+    void flush() {
+        EEPROMwl.put(slot_idx(today.day), today);
+        last_flush = millis();
+    }
+
+    // Returns today's record
+    const DayRuntime& get_today() const {
+        return today;
+    }
+
+    // Returns the total for `output` over the last N_RUNTIME_DAYS days, including today
+    OutputRuntime get_week_total(Output output) {
+        OutputRuntime total = {0, 0};
+        for (uint8_t i = 0; i < N_RUNTIME_DAYS; i++) {
+            DayRuntime record;
+            if (!get_day(today.day - i, record)) {
+                continue;
+            }
+            total.minutes += record.outputs[output].minutes;
+            total.cycles += record.outputs[output].cycles;
+        }
+        return total;
+    }
+
+    // Prints the last N_RUNTIME_DAYS days as CSV, oldest first
+    void export_csv(Print& out) {
+        out.println(F("day,heat_min,heat_cycles,cool_min,cool_cycles,fan_min,fan_cycles"));
+        for (int8_t i = N_RUNTIME_DAYS - 1; i >= 0; i--) {
+            DayRuntime record;
+            if (!get_day(today.day - i, record)) {
+                continue;
+            }
+            out.print(record.day);
+            for (uint8_t o = 0; o < N_OUTPUTS; o++) {
+                out.print(',');
+                out.print(record.outputs[o].minutes);
+                out.print(',');
+                out.print(record.outputs[o].cycles);
+            }
+            out.println();
+        }
+    }
+
+    private:
+    RTC_DS1307* rtc;
+    DayRuntime today;
+    unsigned long run_ms[N_OUTPUTS];
+    uint8_t last_outputs;
+    unsigned long last_update;
+    unsigned long last_flush;
+
+    // Returns the current day number, or the day already being logged if the RTC isn't running
+    uint16_t current_day() {
+        if (!rtc->isrunning()) {
+            return today.day;
+        }
+        return rtc->now().unixtime() / SECONDS_PER_DAY;
+    }
+
+    // Reads the record for `day` into `record`. Returns `false` if there is none.
+    bool get_day(uint16_t day, DayRuntime& record) {
+        if (day == today.day) {
+            record = today;
+            return true;
+        }
+        EEPROMwl.get(slot_idx(day), record);
+        return record.day == day;
+    }
+
+    static int slot_idx(uint16_t day) {
+        return RUNTIME_START_IDX + day % N_RUNTIME_DAYS;
+    }
+};
+
+#endif
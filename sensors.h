@@ -0,0 +1,123 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <DHT.h>
+
+// How the readings of a group of sensors are combined into one temperature
+enum AggregateMode {
+    Average = 0,
+    Minimum = 1,
+    Maximum = 2,
+    Weighted = 3
+};
+
+/*
+A group of temperature / humidity sensors that are read together and reduced to one value
+`sensors` and `weights` are owned by the caller and have to outlive the group
+*/
+class SensorGroup {
+    public:
+    SensorGroup(DHT** sensors, const float* weights, uint8_t n_sensors, AggregateMode mode) {
+        this->sensors = sensors;
+        this->weights = weights;
+        this->n_sensors = n_sensors;
+        this->mode = mode;
+        last_temp = NAN;
+        last_humidity = NAN;
+    }
+
+    void begin() {
+        for (uint8_t i = 0; i < n_sensors; i++) {
+            sensors[i]->begin();
+        }
+    }
+
+    /*
+    Reads every sensor and returns the aggregated temperature
+    Humidity is taken from the same DHT transaction and is available from `humidity()` afterwards.
+    Sensors that fail to read are left out. Returns NAN if none of them could be read.
+    */
+    float read_temperature() {
+        Aggregate temp_agg = {0, 0, 0};
+        Aggregate humidity_agg = {0, 0, 0};
+        for (uint8_t i = 0; i < n_sensors; i++) {
+            // Only `read` talks to the sensor, the readTemperature / readHumidity calls use its cached result
+            if (!sensors[i]->read()) {
+                continue;
+            }
+            add_reading(temp_agg, sensors[i]->readTemperature(), weights[i]);
+            add_reading(humidity_agg, sensors[i]->readHumidity(), weights[i]);
+        }
+        last_temp = aggregate_result(temp_agg);
+        last_humidity = aggregate_result(humidity_agg);
+        return last_temp;
+    }
+
+    // Sets the last reading, used to resume from a warm restart before the sensors have been read
+    void restore(float temp, float humidity) {
+        last_temp = temp;
+        last_humidity = humidity;
+    }
+
+    // Returns the temperature from the last call to `read_temperature`
+    float temperature() const {
+        return last_temp;
+    }
+
+    // Returns the relative humidity (%) from the last call to `read_temperature`
+    float humidity() const {
+        return last_humidity;
+    }
+
+    // Returns the heat index ("feels like" temperature) in celsius of the last reading
+    float heat_index() {
+        if (n_sensors == 0 || isnan(last_temp) || isnan(last_humidity)) {
+            return NAN;
+        }
+        return sensors[0]->computeHeatIndex(last_temp, last_humidity, false);
+    }
+
+    private:
+    DHT** sensors;
+    const float* weights;
+    uint8_t n_sensors;
+    AggregateMode mode;
+    float last_temp;
+    float last_humidity;
+
+    struct Aggregate {
+        float total;
+        float total_weight;
+        uint8_t n_read;
+    };
+
+    void add_reading(Aggregate& agg, float value, float weight) {
+        if (isnan(value)) {
+            return;
+        }
+        if (mode == AggregateMode::Minimum) {
+            agg.total = (agg.n_read == 0 || value < agg.total) ? value : agg.total;
+        } else if (mode == AggregateMode::Maximum) {
+            agg.total = (agg.n_read == 0 || value > agg.total) ? value : agg.total;
+        } else if (mode == AggregateMode::Weighted) {
+            agg.total += value * weight;
+            agg.total_weight += weight;
+        } else {
+            agg.total += value;
+            agg.total_weight += 1;
+        }
+        agg.n_read++;
+    }
+
+    float aggregate_result(const Aggregate& agg) const {
+        if (agg.n_read == 0) {
+            return NAN;
+        }
+        if (mode == AggregateMode::Average || mode == AggregateMode::Weighted) {
+            return agg.total_weight > 0 ? agg.total / agg.total_weight : NAN;
+        }
+        return agg.total;
+    }
+};
+
+#endif
@@ -7,26 +7,59 @@
 #include <RTClib.h>
 
 /*
-EEPROM section layout
+EEPROM section layout (repeated once per zone, zone n starts at n * N_INDEXES)
 0 - Mode setting (Off / Cool / Heat / Fan)
 1 - Complex/Simple temperature mode setting
 2 - Simple temperature setting
 3 - Number of complex temperatures
-4 - 20 - Complex temperature settings
+4 - Humidity setting
+5 - Auto mode changeover lockout
+6 - 22 - Complex temperature settings
+
+After the zone sections
+N_INDEXES * N_ZONES onwards - N_RUNTIME_DAYS daily runtime records (see runtime.h)
 */
 
+// Number of independently controlled zones
+#ifndef N_ZONES
+#define N_ZONES 1
+#endif
+#if N_ZONES < 1 || N_ZONES > 15
+#error "N_ZONES has to be between 1 and 15"
+#endif
+
 // EEPROMwl config
-#define N_INDEXES 21
+// NOTE: EEPROM_LAYOUT_REVISION has to be bumped whenever the layout changes
+// N_ZONES is folded into the version, so changing it resets the EEPROM instead of misreading another zone's section
+#define EEPROM_LAYOUT_REVISION 5
+#define EEPROM_LAYOUT_VERSION (EEPROM_LAYOUT_REVISION * 16 + N_ZONES)
+#define N_INDEXES 23
+#define N_RUNTIME_DAYS 7
+#define N_TOTAL_INDEXES (N_INDEXES * N_ZONES + N_RUNTIME_DAYS)
+// EEPROMwl splits the EEPROM after its version byte evenly between the indexes and spends a control bit per data byte
+#define EEPROM_INDEX_BYTES ((E2END + 1 - 1) / N_TOTAL_INDEXES * 8 / 9)
 
 // EEPROM layout
 #define MODE_IDX 0
 #define CONTROL_MODE_IDX 1
 #define SIMPLE_TEMP_IDX 2
 #define N_CMPLX_TEMPS_IDX 3
-#define CMPLX_START_IDX 4
+#define HUMIDITY_IDX 4
+#define CHANGEOVER_LOCKOUT_IDX 5
+#define CMPLX_START_IDX 6
+#define RUNTIME_START_IDX (N_INDEXES * N_ZONES)
 
 // number of indexes - total size of reserved indexes
-#define MAX_CMPLX_TEMPS N_INDEXES - 5
+#define MAX_CMPLX_TEMPS N_INDEXES - 7
+
+// Humidity defaults, used when the EEPROM doesn't hold a valid humidity setting
+#define DEFAULT_TARGET_HUMIDITY 50
+#define DEFAULT_HUMIDITY_THRESHOLD 5
+#define MAX_HUMIDITY_THRESHOLD 50
+
+// Auto mode changeover lockout limits in minutes
+#define DEFAULT_CHANGEOVER_LOCKOUT 10
+#define MAX_CHANGEOVER_LOCKOUT 120
 
 // setting constants
 enum Mode {
@@ -42,40 +75,61 @@ enum ControlMode {
     Complex = 1,
 };
 
-// There should only ever be one Settings object at a time
-bool _settings_lock = false;
+// Minimum gap in celsius between the heating and cooling setpoints
+#define MIN_DEADBAND 2.0
 
 class TempSetting {
     public:
     TempSetting() {
-        _target_temp = 0;
+        _heat_temp = 0;
+        _cool_temp = 0;
         _start_time = -1;
     }
-    // t_temp - target temp in celsius, s_time - start time in seconds
-    TempSetting(float t_temp, long s_time) {
-        target_temp(t_temp);
+    // h_temp / c_temp - heating / cooling setpoints in celsius, s_time - start time in seconds
+    TempSetting(float h_temp, float c_temp, long s_time) {
+        set_temps(h_temp, c_temp);
         start_time(s_time);
     }
-    TempSetting(float t_temp, DateTime& time) {
-        target_temp(t_temp);
+    TempSetting(float h_temp, float c_temp, DateTime& time) {
+        set_temps(h_temp, c_temp);
         long s_time = time.second() + (time.minute() + time.hour() * 60) * 60;
         start_time(s_time);
     }
-    TempSetting(float t_temp, long hour, long minute) {
+    TempSetting(float h_temp, float c_temp, long hour, long minute) {
         long s_time = 60 * (minute + hour * 60);
-        target_temp(t_temp);
+        set_temps(h_temp, c_temp);
         start_time(s_time);
     }
     TempSetting(TempSetting& other) {
-        _target_temp = other._target_temp;
+        _heat_temp = other._heat_temp;
+        _cool_temp = other._cool_temp;
         _start_time = other._start_time;
     }
 
-    float target_temp() const {
-        return decompress_target_temp(_target_temp);
+    float heat_temp() const {
+        return decompress_target_temp(_heat_temp);
     }
-    void target_temp(float new_temp) {
-        _target_temp = compress_target_temp(new_temp);
+    float cool_temp() const {
+        return decompress_target_temp(_cool_temp);
+    }
+    // Returns the setpoint `mode` controls to (the heating setpoint for every mode but Cool)
+    float target_temp(Mode mode) const {
+        if (mode == Mode::Cool) {
+            return cool_temp();
+        }
+        return heat_temp();
+    }
+    // Sets both setpoints, raising the cooling setpoint if they're closer than MIN_DEADBAND
+    void set_temps(float h_temp, float c_temp) {
+        if (c_temp - h_temp < MIN_DEADBAND) {
+            c_temp = h_temp + MIN_DEADBAND;
+        }
+        _heat_temp = compress_target_temp(h_temp);
+        _cool_temp = compress_target_temp(c_temp);
+    }
+    // Moves both setpoints by `delta` degrees
+    void shift(float delta) {
+        set_temps(heat_temp() + delta, cool_temp() + delta);
     }
     long start_time() const {
         return _start_time;
@@ -84,8 +138,8 @@ class TempSetting {
         _start_time = new_time;
     }
 
-    // Returns a human-readable string representation
-    const String to_string() const {
+    // Returns the start time as "HH:MM"
+    const String time_string() const {
         long m = start_time() / 60;
         long hour = floor(m / 60);
         long minute = m - hour * 60;
@@ -98,7 +152,15 @@ class TempSetting {
         while (minute_str.length() < 2) {
             minute_str = '0' + minute_str;
         }
-        return hour_str + ':' + minute_str + ": " + String(target_temp());
+        return hour_str + ':' + minute_str;
+    }
+
+    /*
+    Returns a compact human-readable string representation, e.g. "06:30 20-22.5"
+    If `half` is given it's written in place of ".5", which keeps the string within 13 characters
+    */
+    const String to_string(char half = 0) const {
+        return time_string() + ' ' + format_temp(heat_temp(), half) + '-' + format_temp(cool_temp(), half);
     }
 
     bool operator>(const TempSetting& other) {
@@ -106,9 +168,23 @@ class TempSetting {
     }
 
     private:
-    byte _target_temp;
+    byte _heat_temp;
+    byte _cool_temp;
     long _start_time;
 
+    // Formats a setpoint without the redundant ".0" (setpoints are stored in half degrees)
+    static String format_temp(float temp, char half) {
+        long whole = floor(temp);
+        String temp_str = String(whole);
+        if (temp != whole) {
+            if (half) {
+                temp_str += half;
+            } else {
+                temp_str += F(".5");
+            }
+        }
+        return temp_str;
+    }
     static float decompress_target_temp(byte temp) {
         float n = (float) temp;
         n /= 2;
@@ -120,18 +196,24 @@ class TempSetting {
     }
 };
 
+// Relative humidity target (%) and how far above it the humidity can go before dehumidifying
+struct HumiditySetting {
+    uint8_t target;
+    uint8_t threshold;
+};
+
 class Settings {
     public:
     Mode mode;
     ControlMode control_mode;
     TempSetting simple_temp_setting;
+    HumiditySetting humidity_setting;
+    // Minutes Auto mode waits after heating before it may cool, and vice versa
+    uint8_t changeover_lockout;
     arx::vector<TempSetting> temp_settings;
 
-    Settings() {
-        _settings_lock = true;
-    }
-    ~Settings() {
-        _settings_lock = false;
+    Settings(uint8_t zone = 0) {
+        this->zone = zone;
     }
     void begin() {
         /*
@@ -141,17 +223,26 @@ class Settings {
         maybe it doesn't matter if EEPROMwl is initialized multiple
         times if it's done the same way?
         */
-        EEPROMwl.begin(2, N_INDEXES);
+        EEPROMwl.begin(EEPROM_LAYOUT_VERSION, N_TOTAL_INDEXES);
         // Read settings from EEPROM
-        EEPROMwl.get(MODE_IDX, mode);
-        EEPROMwl.get(CONTROL_MODE_IDX, control_mode);
-        EEPROMwl.get(SIMPLE_TEMP_IDX, simple_temp_setting);
+        EEPROMwl.get(idx(MODE_IDX), mode);
+        EEPROMwl.get(idx(CONTROL_MODE_IDX), control_mode);
+        EEPROMwl.get(idx(SIMPLE_TEMP_IDX), simple_temp_setting);
+        EEPROMwl.get(idx(HUMIDITY_IDX), humidity_setting);
+        if (humidity_setting.target > 100 || humidity_setting.threshold > 100) {
+            humidity_setting.target = DEFAULT_TARGET_HUMIDITY;
+            humidity_setting.threshold = DEFAULT_HUMIDITY_THRESHOLD;
+        }
+        EEPROMwl.get(idx(CHANGEOVER_LOCKOUT_IDX), changeover_lockout);
+        if (changeover_lockout > MAX_CHANGEOVER_LOCKOUT) {
+            changeover_lockout = DEFAULT_CHANGEOVER_LOCKOUT;
+        }
         size_t n_temp_settings = 0;
-        EEPROMwl.get(N_CMPLX_TEMPS_IDX, n_temp_settings);
+        EEPROMwl.get(idx(N_CMPLX_TEMPS_IDX), n_temp_settings);
         temp_settings.reserve(MAX_CMPLX_TEMPS);
         for (size_t offset = 0; offset < n_temp_settings; offset++) {
             TempSetting ts;
-            EEPROMwl.get(CMPLX_START_IDX + offset, ts);
+            EEPROMwl.get(idx(CMPLX_START_IDX + offset), ts);
             temp_settings.push_back(ts);
         }
     }
@@ -159,17 +250,39 @@ class Settings {
     // Saves settings to EEPROM
     void save_settings() {
         Serial.println(F("Saving settings to EEPROM... "));
-        EEPROMwl.put(MODE_IDX, mode);
-        EEPROMwl.put(CONTROL_MODE_IDX, control_mode);
-        EEPROMwl.put(SIMPLE_TEMP_IDX, simple_temp_setting);
+        EEPROMwl.put(idx(MODE_IDX), mode);
+        EEPROMwl.put(idx(CONTROL_MODE_IDX), control_mode);
+        EEPROMwl.put(idx(SIMPLE_TEMP_IDX), simple_temp_setting);
+        EEPROMwl.put(idx(HUMIDITY_IDX), humidity_setting);
+        EEPROMwl.put(idx(CHANGEOVER_LOCKOUT_IDX), changeover_lockout);
 
-        EEPROMwl.put(N_CMPLX_TEMPS_IDX, temp_settings.size());
+        EEPROMwl.put(idx(N_CMPLX_TEMPS_IDX), temp_settings.size());
         for (int offset = 0; offset < temp_settings.size(); offset++) {
-            EEPROMwl.put(CMPLX_START_IDX + offset, temp_settings[offset]);
+            EEPROMwl.put(idx(CMPLX_START_IDX + offset), temp_settings[offset]);
         }
         Serial.println(F("Done!"));
     }
 
+    // Prints the settings in a human-readable form
+    void print_settings(Print& out) {
+        out.print(F("mode: "));
+        out.println(mode);
+        out.print(F("control_mode: "));
+        out.println(control_mode);
+        out.print(F("simple: "));
+        out.println(simple_temp_setting.to_string());
+        out.print(F("humidity: "));
+        out.print(humidity_setting.target);
+        out.print('/');
+        out.println(humidity_setting.threshold);
+        out.print(F("changeover_lockout: "));
+        out.println(changeover_lockout);
+        for (size_t i = 0; i < temp_settings.size(); i++) {
+            out.print(F("schedule: "));
+            out.println(temp_settings[i].to_string());
+        }
+    }
+
     /*
     Returns the TempSetting for the current time
     (or the simple setting if the control mode is simple OR `time` is NULL)
@@ -213,8 +326,8 @@ class Settings {
         return 0;
     }
 
-    int add_temp_setting(float temp, uint8_t hour, uint8_t minute) {
-        TempSetting ts(temp, hour, minute);
+    int add_temp_setting(float heat_temp, float cool_temp, uint8_t hour, uint8_t minute) {
+        TempSetting ts(heat_temp, cool_temp, (long) hour, (long) minute);
         return add_temp_setting(ts);
     }
 
@@ -229,6 +342,13 @@ class Settings {
     }
 
     private:
+    uint8_t zone;
+
+    // Returns the EEPROMwl index of `offset` within this zone's section
+    int idx(int offset) const {
+        return zone * N_INDEXES + offset;
+    }
+
     void sort_temp_settings() {
         qsort(
             temp_settings.data(),
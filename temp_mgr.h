@@ -4,29 +4,92 @@
 
 #include <RTClib.h>
 
+#include "runtime.h"
 #include "settings.h"
+#include "weather.h"
 
+// Relay pins for the primary zone
 #define HEAT_PIN 3
 #define COOL_PIN 4
 #define FAN_PIN 5
 
 #define TEMP_THRESHOLD 0.5
+// How far past its target cooling may run while the humidity is above its threshold
+#define DEHUMIDIFY_OVERCOOL 1.0
+// Minimum time in ms the compressor has to stay off before cooling can start again
+#define MIN_COMPRESSOR_OFF_TIME 180000UL
+
+// The set of relays driven by one TempMgr
+struct RelayPins {
+    uint8_t heat;
+    uint8_t cool;
+    uint8_t fan;
+};
+
+/*
+Control state that has to survive a warm restart (see restart.h)
+Times are stored as ages (ms before the snapshot) since millis() restarts at 0 after a reset
+*/
+struct TempMgrState {
+    uint8_t running_mode;
+    uint8_t last_active_mode;
+    unsigned long last_change_age;
+    unsigned long last_active_age;
+    unsigned long compressor_off_age;
+    float heat_loss;
+};
 
 class TempMgr {
     public:
-    TempMgr(Settings* settings, RTC_DS1307* rtc) {
+    // `outdoor` may be NULL if there's no outdoor temperature to compensate with
+    TempMgr(Settings* settings, RTC_DS1307* rtc, RelayPins pins, OutdoorTemp* outdoor = NULL) {
         this->settings = settings;
         this->rtc = rtc;
-        last_called = 0;
+        this->pins = pins;
+        this->outdoor = outdoor;
+        reset_state();
     }
     TempMgr(const TempMgr& tmgr) {
         settings = tmgr.settings;
         rtc = tmgr.rtc;
-        last_called = 0;
+        pins = tmgr.pins;
+        outdoor = tmgr.outdoor;
+        reset_state();
+    }
+    // Sets up the relay pins and turns every relay off
+    void begin() {
+        pinMode(pins.heat, OUTPUT);
+        pinMode(pins.cool, OUTPUT);
+        pinMode(pins.fan, OUTPUT);
+        digitalWrite(pins.heat, HIGH);
+        digitalWrite(pins.cool, HIGH);
+        digitalWrite(pins.fan, HIGH);
+    }
+    // Copies the control state into `state`
+    void save_state(TempMgrState& state) const {
+        unsigned long now = millis();
+        state.running_mode = running_mode;
+        state.last_active_mode = last_active_mode;
+        state.last_change_age = now - last_change;
+        state.last_active_age = now - last_active_end;
+        state.compressor_off_age = now - compressor_off_since;
+        state.heat_loss = heat_loss.coefficient;
+    }
+    // Restores the control state saved before a reset and drives the relays to match
+    void restore_state(const TempMgrState& state) {
+        unsigned long now = millis();
+        running_mode = (Mode) state.running_mode;
+        last_active_mode = (Mode) state.last_active_mode;
+        last_change = now - state.last_change_age;
+        last_active_end = now - state.last_active_age;
+        compressor_off_since = now - state.compressor_off_age;
+        heat_loss.coefficient = state.heat_loss;
+        write_relays();
     }
     // Updates whether the thermostat is currently calling for heat, cooling, the fan, or neither
+    // `current_humidity` may be NAN if it is unknown
     // Returns `true` if the call changes
-    bool update_call(float current_temp) {
+    bool update_call(float current_temp, float current_humidity = NAN) {
         // Set the temperature mode to simple if the RTC isn't running
         const TempSetting* tgt_temp = NULL;
         Mode old_mode = running_mode;
@@ -39,94 +102,181 @@ class TempMgr {
             tgt_temp = settings->get_current_setting(&now);
         }
 
+        /*
+        Weather compensation: shift the setpoints with the outdoor temperature, then switch on early
+        by however far the temperature is expected to drift before the equipment catches up
+        */
+        float outdoor_temp = outdoor ? outdoor->temperature() : NAN;
+        heat_loss.update(current_temp, outdoor_temp, running_mode == Mode::Off || running_mode == Mode::Fan);
+        float heat_tgt = tgt_temp->heat_temp() + outdoor_reset_heat(outdoor_temp);
+        float cool_tgt = tgt_temp->cool_temp() + outdoor_reset_cool(outdoor_temp);
+        // The resets move the setpoints separately, so keep them MIN_DEADBAND apart the same way `set_temps` does
+        if (cool_tgt < heat_tgt + MIN_DEADBAND) {
+            cool_tgt = heat_tgt + MIN_DEADBAND;
+        }
+        float drift = heat_loss.expected_drift(current_temp, outdoor_temp);
+        float heat_on_temp = heat_tgt - TEMP_THRESHOLD - constrain(drift, (float) -TEMP_THRESHOLD, 0.0f);
+        float cool_on_temp = cool_tgt + TEMP_THRESHOLD - constrain(drift, 0.0f, (float) TEMP_THRESHOLD);
+
         if (settings->mode == Mode::Off) {
-            digitalWrite(HEAT_PIN, HIGH);
-            digitalWrite(COOL_PIN, HIGH);
-            digitalWrite(FAN_PIN, HIGH);
+            digitalWrite(pins.heat, HIGH);
+            digitalWrite(pins.cool, HIGH);
+            digitalWrite(pins.fan, HIGH);
             running_mode = Mode::Off;
         }
         else if (settings->mode == Mode::Fan) {
-            digitalWrite(HEAT_PIN, HIGH);
-            digitalWrite(COOL_PIN, HIGH);
-            digitalWrite(FAN_PIN, LOW);
+            digitalWrite(pins.heat, HIGH);
+            digitalWrite(pins.cool, HIGH);
+            digitalWrite(pins.fan, LOW);
             running_mode = Mode::Fan;
         }
         else if (settings->mode == Mode::Heat) {
-            if (current_temp < tgt_temp->target_temp() - TEMP_THRESHOLD) {
-                digitalWrite(HEAT_PIN, LOW);
-                digitalWrite(FAN_PIN, LOW);
+            if (current_temp < heat_on_temp) {
+                digitalWrite(pins.heat, LOW);
+                digitalWrite(pins.fan, LOW);
                 running_mode = Mode::Heat;
             }
-            else if (current_temp > tgt_temp->target_temp() + TEMP_THRESHOLD) {
-                digitalWrite(HEAT_PIN, HIGH);
-                digitalWrite(FAN_PIN, HIGH);
+            else if (current_temp > heat_tgt + TEMP_THRESHOLD) {
+                digitalWrite(pins.heat, HIGH);
+                digitalWrite(pins.fan, HIGH);
                 running_mode = Mode::Off;
             }
-            digitalWrite(COOL_PIN, HIGH);
+            digitalWrite(pins.cool, HIGH);
         }
         else if (settings->mode == Mode::Cool) {
-            if (current_temp > tgt_temp->target_temp() + TEMP_THRESHOLD) {
-                digitalWrite(COOL_PIN, LOW);
-                digitalWrite(FAN_PIN, LOW);
+            if (current_temp > cool_on_temp && compressor_ready()) {
+                digitalWrite(pins.cool, LOW);
+                digitalWrite(pins.fan, LOW);
                 running_mode = Mode::Cool;
             }
-            else if (current_temp < tgt_temp->target_temp() - TEMP_THRESHOLD) {
-                digitalWrite(COOL_PIN, HIGH);
-                digitalWrite(FAN_PIN, HIGH);
+            // Extend the run to pull more moisture out of the air while it's too humid
+            else if (current_temp < cool_tgt - TEMP_THRESHOLD - dehumidify_overcool(current_humidity)) {
+                digitalWrite(pins.cool, HIGH);
+                digitalWrite(pins.fan, HIGH);
                 running_mode = Mode::Off;
             }
-            digitalWrite(HEAT_PIN, HIGH);
+            digitalWrite(pins.heat, HIGH);
         }
         else if (settings->mode == Mode::Auto) {
+            // Heating and cooling each use their own setpoint, which are kept MIN_DEADBAND apart
             if (running_mode == Mode::Heat) {
-                if (current_temp > tgt_temp->target_temp()) {
-                    digitalWrite(HEAT_PIN, HIGH);
-                    digitalWrite(FAN_PIN, HIGH);
+                if (current_temp > heat_tgt + TEMP_THRESHOLD) {
+                    digitalWrite(pins.heat, HIGH);
+                    digitalWrite(pins.fan, HIGH);
                     running_mode = Mode::Off;
                 }
             }
             else if (running_mode == Mode::Cool) {
-                if (current_temp < tgt_temp->target_temp()) {
-                    digitalWrite(COOL_PIN, HIGH);
-                    digitalWrite(FAN_PIN, HIGH);
+                if (current_temp < cool_tgt - TEMP_THRESHOLD - dehumidify_overcool(current_humidity)) {
+                    digitalWrite(pins.cool, HIGH);
+                    digitalWrite(pins.fan, HIGH);
                     running_mode = Mode::Off;
                 }
             }
             else {
-                if (current_temp < tgt_temp->target_temp() - TEMP_THRESHOLD) {
-                    digitalWrite(HEAT_PIN, LOW);
-                    digitalWrite(FAN_PIN, LOW);
+                if (current_temp < heat_on_temp && !changeover_locked(Mode::Heat)) {
+                    digitalWrite(pins.heat, LOW);
+                    digitalWrite(pins.fan, LOW);
                     running_mode = Mode::Heat;
                 }
-                if (current_temp > tgt_temp->target_temp() + TEMP_THRESHOLD) {
-                    digitalWrite(COOL_PIN, LOW);
-                    digitalWrite(FAN_PIN, LOW);
+                else if (current_temp > cool_on_temp && !changeover_locked(Mode::Cool) && compressor_ready()) {
+                    digitalWrite(pins.cool, LOW);
+                    digitalWrite(pins.fan, LOW);
                     running_mode = Mode::Cool;
                 }
             }
         }
 
+        if (running_mode != old_mode) {
+            last_change = millis();
+            // Remember when heating or cooling last stopped for the changeover lockout
+            if (old_mode == Mode::Heat || old_mode == Mode::Cool) {
+                last_active_mode = old_mode;
+                last_active_end = last_change;
+            }
+            if (old_mode == Mode::Cool) {
+                compressor_off_since = last_change;
+            }
+        }
+
         return running_mode != old_mode;
     }
+    bool is_running() {
+        return running_mode != Mode::Off;
+    }
+    // Returns the learned heat-loss coefficient in 1/h
+    float heat_loss_coefficient() const {
+        return heat_loss.coefficient;
+    }
+    // Returns a bitmask of the `Output`s that are currently on
+    uint8_t outputs() {
+        if (running_mode == Mode::Heat) {
+            return bit(HeatOutput) | bit(FanOutput);
+        } else if (running_mode == Mode::Cool) {
+            return bit(CoolOutput) | bit(FanOutput);
+        } else if (running_mode == Mode::Fan) {
+            return bit(FanOutput);
+        }
+        return 0;
+    }
+    private:
+    void reset_state() {
+        running_mode = Mode::Off;
+        last_active_mode = Mode::Off;
+        last_change = 0;
+        last_active_end = 0;
+        // Treat the compressor as having just stopped, it may have been running before power was lost
+        compressor_off_since = millis();
+    }
+
+    // Drives the relays to match `running_mode`
+    void write_relays() {
+        digitalWrite(pins.heat, running_mode == Mode::Heat ? LOW : HIGH);
+        digitalWrite(pins.cool, running_mode == Mode::Cool ? LOW : HIGH);
+        digitalWrite(pins.fan, running_mode == Mode::Off ? HIGH : LOW);
+    }
+
+    // Returns `true` once the compressor has been off for MIN_COMPRESSOR_OFF_TIME
+    bool compressor_ready() {
+        return millis() - compressor_off_since >= MIN_COMPRESSOR_OFF_TIME;
+    }
+
     /*
-    If 2000ms has passed since the last call of update_call, calls update_call and returns true
-    otherwise returns false
+    Returns `true` if Auto mode has to wait before starting `next_mode`,
+    because the opposite mode stopped less than `changeover_lockout` minutes ago
     */
-    bool update_call_timer(float current_temp) {
-        if (millis() - last_called < 2000) {
+    bool changeover_locked(Mode next_mode) {
+        if (last_active_mode == Mode::Off || last_active_mode == next_mode) {
             return false;
         }
-        last_called = millis();
-        return update_call(current_temp);
+        unsigned long lockout = (unsigned long) settings->changeover_lockout * 60000UL;
+        return millis() - last_active_end < lockout;
     }
-    bool is_running() {
-        return running_mode != Mode::Off;
+
+    // Returns how far past its target cooling should run to dehumidify
+    float dehumidify_overcool(float current_humidity) {
+        if (isnan(current_humidity)) {
+            return 0;
+        }
+        const HumiditySetting& hs = settings->humidity_setting;
+        if (current_humidity > hs.target + hs.threshold) {
+            return DEHUMIDIFY_OVERCOOL;
+        }
+        return 0;
     }
-    private:
+
     Settings* settings;
     RTC_DS1307* rtc;
-    unsigned long last_called;
+    RelayPins pins;
+    OutdoorTemp* outdoor;
+    HeatLossModel heat_loss;
     Mode running_mode;
+    // When `running_mode` last changed
+    unsigned long last_change;
+    // Last of Heat / Cool that ran, and when it stopped
+    Mode last_active_mode;
+    unsigned long last_active_end;
+    unsigned long compressor_off_since;
 };
 
 #endif
@@ -0,0 +1,168 @@
+#ifndef WEATHER_H
+#define WEATHER_H
+
+#include <DHT.h>
+
+// Outdoor readings older than this many ms are treated as unknown
+#define OUTDOOR_TEMP_MAX_AGE 1800000UL
+// How often the outdoor sensor is read in ms
+#define OUTDOOR_READ_INTERVAL 60000UL
+// Outdoor readings outside of this range in celsius are rejected as implausible
+#define OUTDOOR_TEMP_MIN -50.0
+#define OUTDOOR_TEMP_MAX 60.0
+
+// Outdoor reset: below HEAT_BALANCE the heating setpoint is raised by GAIN per degree, up to MAX
+#define OUTDOOR_RESET_HEAT_BALANCE 15.0
+// Above COOL_BALANCE the cooling setpoint is raised by GAIN per degree, up to MAX
+#define OUTDOOR_RESET_COOL_BALANCE 30.0
+#define OUTDOOR_RESET_GAIN 0.05
+#define OUTDOOR_RESET_MAX 1.0
+
+// Time in ms the system has to sit idle for one heat-loss sample
+#define HEAT_LOSS_SAMPLE_TIME 600000UL
+// Smallest indoor / outdoor difference a heat-loss sample is taken at
+#define HEAT_LOSS_MIN_DIFF 3.0
+// Weight of each new sample in the learned coefficient
+#define HEAT_LOSS_ALPHA 0.1
+// Samples outside of this range (1/h) are discarded as noise
+#define HEAT_LOSS_MAX 2.0
+// Starting coefficient (1/h) until one has been learned
+#define HEAT_LOSS_DEFAULT 0.1
+// How far ahead in hours the drift is anticipated, roughly the equipment's response time
+#define ANTICIPATION_LEAD 0.1
+
+/*
+Outdoor temperature, read from an optional second sensor or pushed over serial
+*/
+class OutdoorTemp {
+    public:
+    // `sensor` may be NULL if the temperature is only ever pushed with `set`
+    OutdoorTemp(DHT* sensor) {
+        this->sensor = sensor;
+        last_temp = NAN;
+        last_update = 0;
+        last_read = 0;
+    }
+
+    void begin() {
+        if (sensor) {
+            sensor->begin();
+        }
+    }
+
+    // Reads the outdoor sensor every OUTDOOR_READ_INTERVAL
+    void update() {
+        if (!sensor || (last_read != 0 && millis() - last_read < OUTDOOR_READ_INTERVAL)) {
+            return;
+        }
+        last_read = millis();
+        float temp = sensor->readTemperature();
+        if (!isnan(temp)) {
+            set(temp);
+        }
+    }
+
+    /*
+    Sets the outdoor temperature, e.g. from a weather source over serial
+    Returns `false` and keeps the last reading if `temp` isn't plausible
+    */
+    bool set(float temp) {
+        if (isnan(temp) || temp < OUTDOOR_TEMP_MIN || temp > OUTDOOR_TEMP_MAX) {
+            return false;
+        }
+        last_temp = temp;
+        last_update = millis();
+        return true;
+    }
+
+    // Returns the outdoor temperature, or NAN if it's unknown or out of date
+    float temperature() const {
+        if (last_update == 0 || millis() - last_update > OUTDOOR_TEMP_MAX_AGE) {
+            return NAN;
+        }
+        return last_temp;
+    }
+
+    private:
+    DHT* sensor;
+    float last_temp;
+    unsigned long last_update;
+    unsigned long last_read;
+};
+
+/*
+Learns the building's heat-loss coefficient k (1/h) from how fast the indoor temperature drifts
+towards the outdoor temperature while the system is idle: dT/dt = -k * (indoor - outdoor)
+*/
+class HeatLossModel {
+    public:
+    HeatLossModel() {
+        coefficient = HEAT_LOSS_DEFAULT;
+        sampling = false;
+    }
+
+    // Feeds one reading. `idle` is whether heating and cooling were both off since the last one
+    void update(float indoor, float outdoor, bool idle) {
+        if (!idle || isnan(indoor) || isnan(outdoor)) {
+            sampling = false;
+            return;
+        }
+        if (!sampling) {
+            sampling = true;
+            sample_start = millis();
+            start_indoor = indoor;
+            start_outdoor = outdoor;
+            return;
+        }
+        unsigned long elapsed = millis() - sample_start;
+        if (elapsed < HEAT_LOSS_SAMPLE_TIME) {
+            return;
+        }
+        sampling = false;
+        float diff = (start_indoor + indoor) / 2 - (start_outdoor + outdoor) / 2;
+        if (fabs(diff) < HEAT_LOSS_MIN_DIFF) {
+            return;
+        }
+        float hours = elapsed / 3600000.0;
+        float sample = -(indoor - start_indoor) / hours / diff;
+        if (sample <= 0 || sample > HEAT_LOSS_MAX) {
+            return;
+        }
+        coefficient += HEAT_LOSS_ALPHA * (sample - coefficient);
+    }
+
+    // Returns how many degrees the indoor temperature is expected to drift over ANTICIPATION_LEAD
+    float expected_drift(float indoor, float outdoor) const {
+        if (isnan(indoor) || isnan(outdoor)) {
+            return 0;
+        }
+        return -coefficient * (indoor - outdoor) * ANTICIPATION_LEAD;
+    }
+
+    // Learned coefficient in 1/h
+    float coefficient;
+
+    private:
+    bool sampling;
+    unsigned long sample_start;
+    float start_indoor;
+    float start_outdoor;
+};
+
+// Returns how far the heating setpoint is raised for `outdoor`
+float outdoor_reset_heat(float outdoor) {
+    if (isnan(outdoor)) {
+        return 0;
+    }
+    return constrain((OUTDOOR_RESET_HEAT_BALANCE - outdoor) * OUTDOOR_RESET_GAIN, 0.0, OUTDOOR_RESET_MAX);
+}
+
+// Returns how far the cooling setpoint is raised for `outdoor`
+float outdoor_reset_cool(float outdoor) {
+    if (isnan(outdoor)) {
+        return 0;
+    }
+    return constrain((outdoor - OUTDOOR_RESET_COOL_BALANCE) * OUTDOOR_RESET_GAIN, 0.0, OUTDOOR_RESET_MAX);
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef ZONES_H
+#define ZONES_H
+
+#include "sensors.h"
+#include "settings.h"
+#include "temp_mgr.h"
+
+// Time between control ticks in ms
+#define CONTROL_TICK_INTERVAL 2000
+
+// A zone is a set of sensors driving one set of relays, with its own section of the EEPROM settings
+struct Zone {
+    SensorGroup* sensors;
+    TempMgr* temp_mgr;
+    Settings* settings;
+};
+
+/*
+Statically sized table of zones that are all updated from the same control tick
+*/
+template <uint8_t N>
+class ZoneTable {
+    public:
+    ZoneTable(const Zone (&zones)[N]) {
+        for (uint8_t i = 0; i < N; i++) {
+            this->zones[i] = zones[i];
+        }
+        last_tick = 0;
+        ticks = 0;
+        missed_ticks = 0;
+    }
+
+    // Sets up every zone's sensors and relays
+    void begin() {
+        for (uint8_t i = 0; i < N; i++) {
+            zones[i].sensors->begin();
+            zones[i].temp_mgr->begin();
+        }
+    }
+
+    // Reads every zone's settings from EEPROM. Kept apart from `begin` since it's slower than resuming control.
+    void begin_settings() {
+        for (uint8_t i = 0; i < N; i++) {
+            zones[i].settings->begin();
+        }
+    }
+
+    /*
+    If CONTROL_TICK_INTERVAL has passed since the last tick, reads every zone's sensors
+    and updates its call. Returns `true` if any zone's call changed.
+    */
+    bool update_call_timer() {
+        if (last_tick != 0 && millis() - last_tick < CONTROL_TICK_INTERVAL) {
+            return false;
+        }
+        // Count the ticks that were skipped because the caller was busy (e.g. blocked in a menu)
+        if (last_tick != 0) {
+            missed_ticks += (millis() - last_tick) / CONTROL_TICK_INTERVAL - 1;
+        }
+        last_tick = millis();
+        ticks++;
+        bool changed = false;
+        for (uint8_t i = 0; i < N; i++) {
+            float current_temp = zones[i].sensors->read_temperature();
+            float current_humidity = zones[i].sensors->humidity();
+            if (zones[i].temp_mgr->update_call(current_temp, current_humidity)) {
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    // Returns the number of ms until the next control tick is due
+    unsigned long time_until_tick() const {
+        unsigned long elapsed = millis() - last_tick;
+        if (last_tick == 0 || elapsed >= CONTROL_TICK_INTERVAL) {
+            return 0;
+        }
+        return CONTROL_TICK_INTERVAL - elapsed;
+    }
+
+    Zone& operator[](uint8_t idx) {
+        return zones[idx];
+    }
+
+    uint8_t size() const {
+        return N;
+    }
+
+    // Number of control ticks run since boot
+    unsigned long ticks;
+    // Number of control ticks that came at least a whole interval late
+    unsigned long missed_ticks;
+
+    private:
+    Zone zones[N];
+    unsigned long last_tick;
+};
+
+#endif